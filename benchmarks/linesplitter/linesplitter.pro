@@ -0,0 +1,17 @@
+QT += core
+QT -= gui
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+TARGET = linesplitter-bench
+TEMPLATE = app
+
+INCLUDEPATH += ../../ide
+
+SOURCES += \
+    main.cpp \
+    ../../ide/linesplitter.cpp
+
+HEADERS += \
+    ../../ide/linesplitter.h
@@ -0,0 +1,140 @@
+/*
+ * This file is part of Embedded-IDE
+ *
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Throughput of the build output line splitting: LineSplitter against the
+// QString splitting used before it, over synthetic make output.
+//
+// Usage: linesplitter-bench [megabytes] [chunk bytes]
+
+#include "linesplitter.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextCodec>
+#include <QTextStream>
+
+#include <functional>
+
+static QByteArray syntheticOutput(int megabytes)
+{
+    const QList<QByteArray> lines{
+        "make[1]: Entering directory '/home/user/project/src/drivers'",
+        "arm-none-eabi-gcc -c -mcpu=cortex-m4 -mthumb -O2 -g -Wall -Iinc -Idrivers/inc -DSTM32F407xx -MMD -MP src/drivers/uart.c -o build/obj/uart.o",
+        "src/drivers/uart.c:142:17: warning: unused variable 'status' [-Wunused-variable]",
+        "  142 |     uint32_t status = UART->SR;",
+        "      |              ^~~~~~",
+        "src/drivers/spi.c:88:5: error: implicit declaration of function 'spi_wait' [-Werror=implicit-function-declaration]",
+        "Compilando m\xc3\xb3" "dulo \xe2\x80\x9c" "control\xe2\x80\x9d \xe2\x9c\x93",
+        "make[1]: Leaving directory '/home/user/project/src/drivers'",
+    };
+    QByteArray out;
+    out.reserve(megabytes * 1024 * 1024 + 256);
+    for (int i = 0; out.size() < megabytes * 1024 * 1024; i++)
+        out.append(lines.at(i % lines.size())).append(i % 5? "\n" : "\r\n");
+    return out;
+}
+
+struct Result {
+    qint64 lines = 0;
+    qint64 chars = 0;
+};
+
+// Before LineSplitter: every chunk was decoded and the lines cut from a QString
+static Result splitQString(const QByteArray& data, int chunkSize)
+{
+    Result r;
+    QScopedPointer<QTextDecoder> decoder(QTextCodec::codecForName("UTF-8")->makeDecoder());
+    QString buffer;
+    for (int pos = 0; pos < data.size(); pos += chunkSize) {
+        buffer.append(decoder->toUnicode(data.constData() + pos, qMin(chunkSize, data.size() - pos)));
+        int start = 0;
+        int nl;
+        while ((nl = buffer.indexOf('\n', start)) != -1) {
+            int end = nl;
+            if (end > start && buffer.at(end - 1) == '\r')
+                end--;
+            r.lines++;
+            r.chars += buffer.mid(start, end - start).size();
+            start = nl + 1;
+        }
+        buffer.remove(0, start);
+    }
+    if (!buffer.isEmpty()) {
+        r.lines++;
+        r.chars += buffer.size();
+    }
+    return r;
+}
+
+static Result splitLines(const QByteArray& data, int chunkSize, bool decode)
+{
+    Result r;
+    LineSplitter splitter;
+    auto account = [&r, decode](const LineSplitter::Batch& batch) {
+        for (const auto& line: batch) {
+            r.lines++;
+            r.chars += decode? line.toString().size() : line.size;
+        }
+    };
+    for (int pos = 0; pos < data.size(); pos += chunkSize)
+        account(splitter.push(data.mid(pos, chunkSize)));
+    account(splitter.flush());
+    return r;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    auto args = app.arguments();
+    int megabytes = args.size() > 1? args.at(1).toInt() : 32;
+    int chunkSize = args.size() > 2? args.at(2).toInt() : 16384;
+    if (megabytes <= 0 || chunkSize <= 0) {
+        QTextStream(stderr) << "usage: linesplitter-bench [megabytes] [chunk bytes]\n";
+        return 1;
+    }
+
+    auto data = syntheticOutput(megabytes);
+    QTextStream out(stdout);
+    out << QString("%1 MB of make output in %2 byte chunks\n").arg(data.size() / (1024.0 * 1024.0), 0, 'f', 1).arg(chunkSize);
+
+    auto run = [&](const QString& name, const std::function<Result()>& split) {
+        constexpr int ROUNDS = 5;
+        qint64 best = -1;
+        Result r;
+        for (int i = 0; i < ROUNDS; i++) {
+            QElapsedTimer t;
+            t.start();
+            r = split();
+            auto ns = t.nsecsElapsed();
+            if (best < 0 || ns < best)
+                best = ns;
+        }
+        auto mbps = (data.size() / (1024.0 * 1024.0)) / (qMax<qint64>(best, 1) / 1e9);
+        out << QString("%1 %2 MB/s  (%3 lines, %4 chars)\n")
+               .arg(name, -28)
+               .arg(mbps, 8, 'f', 1)
+               .arg(r.lines)
+               .arg(r.chars);
+        out.flush();
+    };
+    run("QString splitting (old)", [&]() { return splitQString(data, chunkSize); });
+    run("LineSplitter + toString", [&]() { return splitLines(data, chunkSize, true); });
+    run("LineSplitter views only", [&]() { return splitLines(data, chunkSize, false); });
+    return 0;
+}
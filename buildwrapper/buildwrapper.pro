@@ -0,0 +1,25 @@
+DESTDIR = ../build
+
+QT += core
+QT -= gui
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+TARGET = buildwrapper
+TEMPLATE = app
+INSTALLS += target
+
+SOURCES += \
+    main.cpp \
+    objectcache.cpp
+
+HEADERS += \
+    objectcache.h
+
+unix {
+    isEmpty(PREFIX) {
+        PREFIX = /usr
+    }
+    target.path = $$PREFIX/bin
+}
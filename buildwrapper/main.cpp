@@ -0,0 +1,179 @@
+/*
+ * This file is part of buildwrapper, utility of Embedded-IDE
+ *
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Used as make SHELL: runs every recipe line with the real shell and appends
+// its start, end, peak RSS and exit status to the trace file as a JSON line.
+// Plain compile lines are served from the object cache when it is enabled.
+
+#include "objectcache.h"
+
+#include <QtCore>
+
+#ifdef Q_OS_UNIX
+#include <cerrno>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+static constexpr auto TRACE_ENV = "EMBEDDED_IDE_BUILD_TRACE";
+static constexpr auto SHELL_ENV = "EMBEDDED_IDE_REAL_SHELL";
+static constexpr auto CACHE_ENV = "EMBEDDED_IDE_COMPILE_CACHE";
+static constexpr auto CACHE_STATS_ENV = "EMBEDDED_IDE_COMPILE_CACHE_STATS";
+
+// Unbuffered append: one write per record, parallel jobs do not interleave
+static void appendRecord(const QByteArray& path, const QByteArray& record)
+{
+    QFile f(QString::fromLocal8Bit(path));
+    if (f.open(QFile::WriteOnly | QFile::Append | QFile::Unbuffered))
+        f.write(record);
+}
+
+// Runs the real shell, the stderr copy is only taken when diagnostics is set
+static int runShell(const QByteArray& shell, int argc, char *argv[], qint64 *rss, QByteArray *diagnostics)
+{
+#ifdef Q_OS_UNIX
+    QVector<char*> args{ const_cast<char*>(shell.constData()) };
+    for (int i = 1; i < argc; i++)
+        args.append(argv[i]);
+    args.append(nullptr);
+    int errPipe[2] = { -1, -1 };
+    if (diagnostics && ::pipe(errPipe) != 0)
+        diagnostics = nullptr;
+    pid_t pid = fork();
+    if (pid == 0) {
+        if (diagnostics) {
+            ::dup2(errPipe[1], STDERR_FILENO);
+            ::close(errPipe[0]);
+            ::close(errPipe[1]);
+        }
+        execvp(shell.constData(), args.data());
+        _exit(127);
+    }
+    if (pid < 0) {
+        perror("fork");
+        return 127;
+    }
+    if (diagnostics) {
+        ::close(errPipe[1]);
+        char buffer[4096];
+        ssize_t n;
+        while ((n = ::read(errPipe[0], buffer, sizeof(buffer))) != 0) {
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                break;
+            }
+            diagnostics->append(buffer, int(n));
+            ssize_t written = 0;
+            while (written < n) {
+                auto w = ::write(STDERR_FILENO, buffer + written, size_t(n - written));
+                if (w <= 0)
+                    break;
+                written += w;
+            }
+        }
+        ::close(errPipe[0]);
+    }
+    int status = 0;
+    struct rusage usage{};
+    while (wait4(pid, &status, 0, &usage) < 0 && errno == EINTR)
+        ;
+    *rss = usage.ru_maxrss;
+#ifdef Q_OS_MACOS
+    *rss /= 1024; // Bytes instead of kilobytes
+#endif
+    return WIFEXITED(status)? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+#else
+    QStringList args;
+    for (int i = 1; i < argc; i++)
+        args.append(QString::fromLocal8Bit(argv[i]));
+    QProcess proc;
+    proc.setProcessChannelMode(QProcess::ForwardedOutputChannel);
+    proc.setInputChannelMode(QProcess::ForwardedInputChannel);
+    proc.start(QString::fromLocal8Bit(shell), args);
+    if (!proc.waitForFinished(-1))
+        return 127;
+    auto err = proc.readAllStandardError();
+    fwrite(err.constData(), 1, size_t(err.size()), stderr);
+    if (diagnostics)
+        *diagnostics = err;
+    *rss = -1;
+    return proc.exitCode();
+#endif
+}
+
+int main(int argc, char *argv[])
+{
+    auto shell = qgetenv(SHELL_ENV);
+    if (shell.isEmpty())
+#ifdef Q_OS_WIN
+        shell = "sh.exe";
+#else
+        shell = "/bin/sh";
+#endif
+    auto trace = qgetenv(TRACE_ENV);
+    auto cacheDir = qgetenv(CACHE_ENV);
+    auto cacheStats = qgetenv(CACHE_STATS_ENV);
+
+#ifdef Q_OS_UNIX
+    if (trace.isEmpty() && cacheDir.isEmpty()) {
+        QVector<char*> args{ shell.data() };
+        for (int i = 1; i < argc; i++)
+            args.append(argv[i]);
+        args.append(nullptr);
+        execvp(shell.constData(), args.data());
+        perror(shell.constData());
+        return 127;
+    }
+#endif
+
+    // QProcess, used for the preprocessor, wants an application instance
+    QCoreApplication app(argc, argv);
+    qint64 start = QDateTime::currentMSecsSinceEpoch();
+    auto command = argc > 1? QString::fromLocal8Bit(argv[argc - 1]) : QString();
+    ObjectCache cache(QString::fromLocal8Bit(cacheDir));
+    bool cacheable = !cacheDir.isEmpty() && argc == 3 && qstrcmp(argv[1], "-c") == 0 && cache.prepare(command);
+    bool hit = cacheable && cache.fetch();
+    int code = 0;
+    qint64 rss = 0;
+    if (!hit) {
+        QByteArray diagnostics;
+        code = runShell(shell, argc, argv, &rss, cacheable? &diagnostics : nullptr);
+        if (cacheable && code == 0)
+            cache.store(diagnostics);
+    }
+    if (cacheable && !cacheStats.isEmpty())
+        appendRecord(cacheStats, hit? "H\n" : "M\n");
+
+    if (!trace.isEmpty()) {
+        QJsonObject record{
+            { "start", start },
+            { "end", QDateTime::currentMSecsSinceEpoch() },
+            { "rss", rss },
+            { "exit", code },
+            { "cmd", command },
+            { "cwd", QDir::currentPath() },
+        };
+        if (hit)
+            record.insert("cached", true);
+        appendRecord(trace, QJsonDocument(record).toJson(QJsonDocument::Compact) + '\n');
+    }
+    return code;
+}
@@ -0,0 +1,225 @@
+/*
+ * This file is part of buildwrapper, utility of Embedded-IDE
+ *
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "objectcache.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <cstdio>
+
+// Only plain commands, anything the shell would expand or chain runs as is
+static bool splitCommand(const QString& cmd, QStringList *out)
+{
+    static const QString special = "|&;<>()$`*?[]{}~\n";
+    QString token;
+    bool inToken = false;
+    QChar quote;
+    for (int i = 0; i < cmd.size(); i++) {
+        auto c = cmd.at(i);
+        if (quote.isNull()) {
+            if (special.contains(c))
+                return false;
+            if (c.isSpace()) {
+                if (inToken)
+                    out->append(token);
+                token.clear();
+                inToken = false;
+            } else if (c == '\'' || c == '"') {
+                quote = c;
+                inToken = true;
+            } else if (c == '\\') {
+                if (i + 1 < cmd.size())
+                    token.append(cmd.at(++i));
+                inToken = true;
+            } else {
+                token.append(c);
+                inToken = true;
+            }
+        } else if (c == quote) {
+            quote = QChar();
+        } else if (quote == '"' && (c == '$' || c == '`')) {
+            return false;
+        } else if (quote == '"' && c == '\\' && i + 1 < cmd.size() && QString("\"\\").contains(cmd.at(i + 1))) {
+            token.append(cmd.at(++i));
+        } else {
+            token.append(c);
+        }
+    }
+    if (!quote.isNull())
+        return false;
+    if (inToken)
+        out->append(token);
+    return true;
+}
+
+static QString optionValue(const QStringList& tokens, int *i, const QString& option)
+{
+    const auto& t = tokens.at(*i);
+    if (t.size() > option.size())
+        return t.mid(option.size());
+    return ++(*i) < tokens.size()? tokens.at(*i) : QString();
+}
+
+bool ObjectCache::prepare(const QString &command)
+{
+    static const QRegularExpression sourceRe(R"(\.(?:c|cc|cpp|cxx|c\+\+|s|S|sx)$)");
+    QStringList tokens;
+    if (!splitCommand(command, &tokens) || tokens.isEmpty())
+        return false;
+    auto compiler = tokens.first();
+    compiler = compiler.contains('/')? QFileInfo(compiler).absoluteFilePath() : QStandardPaths::findExecutable(compiler);
+    QFileInfo compilerInfo(compiler);
+    if (compiler.isEmpty() || !compilerInfo.isExecutable())
+        return false;
+
+    bool compile = false;
+    bool deps = false;
+    bool debugInfo = false;
+    QString source;
+    QStringList preprocess;
+    for (int i = 1; i < tokens.size(); i++) {
+        const auto& t = tokens.at(i);
+        if (t == "-c") {
+            compile = true;
+        } else if (t.startsWith("-o")) {
+            objectFile = optionValue(tokens, &i, "-o");
+        } else if (t == "-MD" || t == "-MMD") {
+            deps = true;
+        } else if (t.startsWith("-MF")) {
+            depFile = optionValue(tokens, &i, "-MF");
+        } else if (t.startsWith("-MT") || t.startsWith("-MQ")) {
+            optionValue(tokens, &i, t.left(3));
+        } else if (t == "-MP") {
+            continue;
+        } else if (t.startsWith("-g") && t != "-g0") {
+            debugInfo = true;
+            preprocess.append(t);
+        } else if (t == "-E" || t == "-S" || t == "-M" || t == "-MM" || t == "-" ||
+                   t.startsWith("-save-temps") || t.startsWith("-fprofile") || t.startsWith("-Wp,")) {
+            return false;
+        } else {
+            if (!t.startsWith('-') && sourceRe.match(t).hasMatch()) {
+                if (!source.isEmpty())
+                    return false;
+                source = t;
+            }
+            preprocess.append(t);
+        }
+    }
+    if (!compile || source.isEmpty() || objectFile.isEmpty())
+        return false;
+    if (!deps)
+        depFile.clear();
+    else if (depFile.isEmpty())
+        depFile = QFileInfo(objectFile).path() + '/' + QFileInfo(objectFile).completeBaseName() + ".d";
+
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(compiler.toUtf8());
+    hash.addData(QByteArray::number(compilerInfo.size()));
+    hash.addData(QByteArray::number(compilerInfo.lastModified().toMSecsSinceEpoch()));
+    hash.addData(tokens.join(QChar('\0')).toUtf8());
+    // DWARF records the compilation directory, the cache is shared by all projects
+    if (debugInfo)
+        hash.addData(QDir::currentPath().toUtf8());
+    // gcc does not preprocess .s files, -E alone misses their content
+    QFile sourceFile(source);
+    if (!sourceFile.open(QFile::ReadOnly))
+        return false;
+    hash.addData(&sourceFile);
+
+    QProcess pp;
+    pp.setStandardErrorFile(QProcess::nullDevice());
+    pp.start(compiler, preprocess << "-E");
+    if (!pp.waitForStarted(-1))
+        return false;
+    while (pp.waitForReadyRead(-1))
+        hash.addData(pp.readAllStandardOutput());
+    pp.waitForFinished(-1);
+    hash.addData(pp.readAllStandardOutput());
+    // Errors are left to the real compiler, it reports them
+    if (pp.exitStatus() != QProcess::NormalExit || pp.exitCode() != 0)
+        return false;
+    key = QString::fromLatin1(hash.result().toHex());
+    return true;
+}
+
+bool ObjectCache::fetch()
+{
+    if (key.isEmpty() || !QFileInfo::exists(entryPath(".o")))
+        return false;
+    if (!depFile.isEmpty() && !QFileInfo::exists(entryPath(".d")))
+        return false;
+    QFile::remove(objectFile);
+    if (!QFile::copy(entryPath(".o"), objectFile))
+        return false;
+    if (!depFile.isEmpty()) {
+        QFile::remove(depFile);
+        QFile::copy(entryPath(".d"), depFile);
+    }
+    QFile err(entryPath(".err"));
+    if (err.open(QFile::ReadOnly)) {
+        auto text = err.readAll();
+        fwrite(text.constData(), 1, size_t(text.size()), stderr);
+    }
+    // The modification time orders the entries for eviction
+    QFile entry(entryPath(".o"));
+    if (entry.open(QFile::ReadWrite))
+        entry.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    return true;
+}
+
+void ObjectCache::store(const QByteArray &diagnostics)
+{
+    if (key.isEmpty())
+        return;
+    QDir().mkpath(QFileInfo(entryPath(".o")).path());
+    auto put = [this](const QString& suffix, const QByteArray& data) {
+        QSaveFile f(entryPath(suffix));
+        return f.open(QFile::WriteOnly) && f.write(data) == data.size() && f.commit();
+    };
+    auto read = [](const QString& path, bool *ok) {
+        QFile f(path);
+        *ok = f.open(QFile::ReadOnly);
+        return *ok? f.readAll() : QByteArray();
+    };
+    bool ok;
+    if (!depFile.isEmpty()) {
+        auto dep = read(depFile, &ok);
+        if (!ok || !put(".d", dep))
+            return;
+    }
+    if (!diagnostics.isEmpty() && !put(".err", diagnostics))
+        return;
+    // The object goes last, its presence marks a complete entry
+    auto object = read(objectFile, &ok);
+    if (ok)
+        put(".o", object);
+}
+
+QString ObjectCache::entryPath(const QString &suffix) const
+{
+    return QString("%1/%2/%3%4").arg(dir, key.left(2), key.mid(2), suffix);
+}
@@ -0,0 +1,47 @@
+/*
+ * This file is part of buildwrapper, utility of Embedded-IDE
+ *
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef OBJECTCACHE_H
+#define OBJECTCACHE_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+// Content addressed cache of compiler outputs. The key covers the compiler
+// identity, the whole command line, the source and its preprocessed output,
+// and the working directory when debug information is generated.
+class ObjectCache
+{
+public:
+    explicit ObjectCache(const QString& dir) : dir(dir) {}
+
+    bool prepare(const QString& command);
+    bool fetch();
+    void store(const QByteArray& diagnostics);
+
+private:
+    QString entryPath(const QString& suffix) const;
+
+    QString dir;
+    QString key;
+    QString objectFile;
+    QString depFile;
+};
+
+#endif // OBJECTCACHE_H
@@ -0,0 +1,162 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "ansitexttranslator.h"
+
+static constexpr ushort ESC = 0x1b;
+static constexpr int MAX_SEQUENCE = 64;
+
+static QColor indexedColor(int i)
+{
+    // Darker than xterm defaults, the console is usually light
+    static const QRgb base[16] = {
+        0x000000, 0xcd0000, 0x00a000, 0xb08000, 0x0000ee, 0xcd00cd, 0x00a0a0, 0x808080,
+        0x555555, 0xff3030, 0x00c000, 0xc0a000, 0x5c5cff, 0xff00ff, 0x00c0c0, 0xa0a0a0,
+    };
+    if (i < 16)
+        return QColor(base[qMax(0, i)]);
+    if (i < 232) {
+        static const int level[6] = { 0, 95, 135, 175, 215, 255 };
+        i -= 16;
+        return QColor(level[i / 36], level[(i / 6) % 6], level[i % 6]);
+    }
+    int gray = 8 + 10 * (qMin(i, 255) - 232);
+    return QColor(gray, gray, gray);
+}
+
+AnsiSpanList AnsiTextTranslator::translate(QString &text)
+{
+    AnsiSpanList spans;
+    if (!partial.isEmpty()) {
+        text.prepend(partial);
+        partial.clear();
+    }
+    int n = text.size();
+    QChar *d = text.data();
+    int out = 0;
+    int runStart = 0;
+    auto closeRun = [&]() {
+        if (out > runStart)
+            spans.append({ runStart, out - runStart, current });
+        runStart = out;
+    };
+    // Output never grows, characters are moved down over consumed sequences
+    int i = 0;
+    while (i < n) {
+        ushort c = d[i].unicode();
+        if (c == '\r') {
+            i++;
+            continue;
+        }
+        if (c != ESC) {
+            d[out++] = d[i++];
+            continue;
+        }
+        if (i + 1 >= n) {
+            partial = text.mid(i);
+            break;
+        }
+        if (d[i + 1] != '[') {
+            i += 2;
+            continue;
+        }
+        int j = i + 2;
+        while (j < n && (d[j].unicode() < 0x40 || d[j].unicode() > 0x7e))
+            j++;
+        if (j >= n) {
+            if (n - i < MAX_SEQUENCE)
+                partial = text.mid(i);
+            break;
+        }
+        if (d[j] == 'm') {
+            closeRun();
+            applySgr(d + i + 2, j - i - 2);
+        }
+        i = j + 1;
+    }
+    closeRun();
+    text.truncate(out);
+    return spans;
+}
+
+void AnsiTextTranslator::reset()
+{
+    current = QTextCharFormat();
+    partial.clear();
+}
+
+QString AnsiTextTranslator::strip(const QString &text)
+{
+    QString s{ text };
+    AnsiTextTranslator().translate(s);
+    return s;
+}
+
+void AnsiTextTranslator::applySgr(const QChar *params, int size)
+{
+    QVector<int> p;
+    int value = 0;
+    for (int i = 0; i < size; i++) {
+        auto c = params[i].unicode();
+        if (c >= '0' && c <= '9') {
+            value = value * 10 + (c - '0');
+        } else if (c == ';' || c == ':') {
+            p.append(value);
+            value = 0;
+        }
+    }
+    p.append(value);
+
+    for (int k = 0; k < p.size(); k++) {
+        int v = p.at(k);
+        if (v == 0) {
+            current = QTextCharFormat();
+        } else if (v == 1) {
+            current.setFontWeight(QFont::Bold);
+        } else if (v == 22) {
+            current.clearProperty(QTextFormat::FontWeight);
+        } else if (v >= 30 && v <= 37) {
+            current.setForeground(indexedColor(v - 30));
+        } else if (v >= 90 && v <= 97) {
+            current.setForeground(indexedColor(v - 90 + 8));
+        } else if (v == 39) {
+            current.clearForeground();
+        } else if (v >= 40 && v <= 47) {
+            current.setBackground(indexedColor(v - 40));
+        } else if (v >= 100 && v <= 107) {
+            current.setBackground(indexedColor(v - 100 + 8));
+        } else if (v == 49) {
+            current.clearBackground();
+        } else if (v == 38 || v == 48) {
+            QColor color;
+            if (k + 2 < p.size() && p.at(k + 1) == 5) {
+                color = indexedColor(qBound(0, p.at(k + 2), 255));
+                k += 2;
+            } else if (k + 4 < p.size() && p.at(k + 1) == 2) {
+                color = QColor(qBound(0, p.at(k + 2), 255), qBound(0, p.at(k + 3), 255), qBound(0, p.at(k + 4), 255));
+                k += 4;
+            }
+            if (!color.isValid())
+                break;
+            if (v == 38)
+                current.setForeground(color);
+            else
+                current.setBackground(color);
+        }
+    }
+}
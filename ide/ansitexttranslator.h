@@ -0,0 +1,54 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ANSITEXTTRANSLATOR_H
+#define ANSITEXTTRANSLATOR_H
+
+#include <QString>
+#include <QTextCharFormat>
+#include <QVector>
+
+struct AnsiSpan {
+    int start;
+    int length;
+    QTextCharFormat format;
+};
+
+using AnsiSpanList = QVector<AnsiSpan>;
+
+class AnsiTextTranslator
+{
+public:
+    // Removes escape sequences and carriage returns from text in place, the
+    // spans cover the remaining text. Sequences cut at the end are completed
+    // with the next call.
+    AnsiSpanList translate(QString& text);
+    void reset();
+
+    bool hasStyle() const { return !current.properties().isEmpty(); }
+
+    static QString strip(const QString& text);
+
+private:
+    void applySgr(const QChar *params, int size);
+
+    QTextCharFormat current;
+    QString partial;
+};
+
+#endif // ANSITEXTTRANSLATOR_H
@@ -400,6 +400,16 @@ bool AppConfig::editorDetectIdent() const
     return priv->local.value("editor").toObject().value("detectIdent").toBool();
 }
 
+int AppConfig::editorLargeFileThreshold() const
+{
+    return priv->local.value("editor").toObject().value("largeFileThreshold").toInt(32);
+}
+
+int AppConfig::editorMaxLiveDocuments() const
+{
+    return priv->local.value("editor").toObject().value("maxLiveDocuments").toInt(24);
+}
+
 QFont AppConfig::loggerFont() const
 {
     auto ed = priv->local.value("logger").toObject();
@@ -409,6 +419,11 @@ QFont AppConfig::loggerFont() const
     return QFont(name, size);
 }
 
+int AppConfig::loggerMaxLines() const
+{
+    return priv->local.value("logger").toObject().value("maxLines").toInt(100000);
+}
+
 QString AppConfig::networkProxyHost() const
 {
     return priv->local.value("network").toObject().value("proxy").toObject().value("host").toString();
@@ -472,6 +487,41 @@ bool AppConfig::numberOfJobsOptimal() const
     return priv->local.value("numberOfJobsOptimal").toBool(false);
 }
 
+bool AppConfig::buildInstrumentation() const
+{
+    return priv->local.value("buildInstrumentation").toBool(false);
+}
+
+bool AppConfig::numberOfJobsAdaptive() const
+{
+    return priv->local.value("numberOfJobsAdaptive").toBool(false);
+}
+
+bool AppConfig::compileCacheEnabled() const
+{
+    return priv->local.value("compileCache").toObject().value("enabled").toBool(false);
+}
+
+int AppConfig::compileCacheMaxSize() const
+{
+    return priv->local.value("compileCache").toObject().value("maxSize").toInt(2048);
+}
+
+bool AppConfig::fileCheckSyntaxOnly() const
+{
+    return priv->local.value("fileCheck").toObject().value("syntaxOnly").toBool(true);
+}
+
+bool AppConfig::fileCheckLive() const
+{
+    return priv->local.value("fileCheck").toObject().value("live").toBool(true);
+}
+
+int AppConfig::fileCheckDelay() const
+{
+    return priv->local.value("fileCheck").toObject().value("delay").toInt(800);
+}
+
 QByteArray AppConfig::fileHash(const QString &filename)
 {
     auto path = QDir(workspacePath()).filePath("hashes.json");
@@ -632,6 +682,20 @@ void AppConfig::setEditorDetectIdent(bool enable)
     priv->local["editor"] = ed;
 }
 
+void AppConfig::setEditorLargeFileThreshold(int megabytes)
+{
+    auto ed = priv->local["editor"].toObject();
+    ed.insert("largeFileThreshold", megabytes);
+    priv->local["editor"] = ed;
+}
+
+void AppConfig::setEditorMaxLiveDocuments(int n)
+{
+    auto ed = priv->local["editor"].toObject();
+    ed.insert("maxLiveDocuments", n);
+    priv->local["editor"] = ed;
+}
+
 void AppConfig::setLoggerFont(const QFont &f)
 {
     auto log = priv->local["logger"].toObject();
@@ -642,6 +706,13 @@ void AppConfig::setLoggerFont(const QFont &f)
     priv->local["logger"] = log;
 }
 
+void AppConfig::setLoggerMaxLines(int lines)
+{
+    auto log = priv->local["logger"].toObject();
+    log.insert("maxLines", lines);
+    priv->local["logger"] = log;
+}
+
 void AppConfig::setNetworkProxyHost(const QString &name)
 {
     auto net = priv->local["network"].toObject();
@@ -729,6 +800,51 @@ void AppConfig::setNumberOfJobsOptimal(bool en)
     priv->local.insert("numberOfJobsOptimal", en);
 }
 
+void AppConfig::setBuildInstrumentation(bool en)
+{
+    priv->local.insert("buildInstrumentation", en);
+}
+
+void AppConfig::setNumberOfJobsAdaptive(bool en)
+{
+    priv->local.insert("numberOfJobsAdaptive", en);
+}
+
+void AppConfig::setCompileCacheEnabled(bool en)
+{
+    auto cache = priv->local["compileCache"].toObject();
+    cache.insert("enabled", en);
+    priv->local["compileCache"] = cache;
+}
+
+void AppConfig::setCompileCacheMaxSize(int megabytes)
+{
+    auto cache = priv->local["compileCache"].toObject();
+    cache.insert("maxSize", megabytes);
+    priv->local["compileCache"] = cache;
+}
+
+void AppConfig::setFileCheckSyntaxOnly(bool en)
+{
+    auto check = priv->local["fileCheck"].toObject();
+    check.insert("syntaxOnly", en);
+    priv->local["fileCheck"] = check;
+}
+
+void AppConfig::setFileCheckLive(bool en)
+{
+    auto check = priv->local["fileCheck"].toObject();
+    check.insert("live", en);
+    priv->local["fileCheck"] = check;
+}
+
+void AppConfig::setFileCheckDelay(int millis)
+{
+    auto check = priv->local["fileCheck"].toObject();
+    check.insert("delay", millis);
+    priv->local["fileCheck"] = check;
+}
+
 void AppConfig::addHash(const QString &filename, const QByteArray &hash)
 {
     auto path = QDir(workspacePath()).filePath("hashes.json");
@@ -72,8 +72,11 @@ public:
     QString editorFormatterStyle() const;
     QString editorFormatterExtra() const;
     bool editorDetectIdent() const;
+    int editorLargeFileThreshold() const;
+    int editorMaxLiveDocuments() const;
 
     QFont loggerFont() const;
+    int loggerMaxLines() const;
 
     QString networkProxyHost() const;
     QString networkProxyPort() const;
@@ -91,6 +94,13 @@ public:
 
     int numberOfJobs() const;
     bool numberOfJobsOptimal() const;
+    bool buildInstrumentation() const;
+    bool numberOfJobsAdaptive() const;
+    bool compileCacheEnabled() const;
+    int compileCacheMaxSize() const;
+    bool fileCheckSyntaxOnly() const;
+    bool fileCheckLive() const;
+    int fileCheckDelay() const;
 
     QByteArray fileHash(const QString& filename);
 
@@ -120,8 +130,11 @@ public slots:
     void setEditorFormatterStyle(const QString& name);
     void setEditorFormatterExtra(const QString& text);
     void setEditorDetectIdent(bool enable);
+    void setEditorLargeFileThreshold(int megabytes);
+    void setEditorMaxLiveDocuments(int n);
 
     void setLoggerFont(const QFont& f);
+    void setLoggerMaxLines(int lines);
 
     void setNetworkProxyHost(const QString& name);
     void setNetworkProxyPort(const QString& port);
@@ -138,6 +151,13 @@ public slots:
 
     void setNumberOfJobs(int n);
     void setNumberOfJobsOptimal(bool en);
+    void setBuildInstrumentation(bool en);
+    void setNumberOfJobsAdaptive(bool en);
+    void setCompileCacheEnabled(bool en);
+    void setCompileCacheMaxSize(int megabytes);
+    void setFileCheckSyntaxOnly(bool en);
+    void setFileCheckLive(bool en);
+    void setFileCheckDelay(int millis);
 
     void addHash(const QString& filename, const QByteArray& hash);
     void purgeHash();
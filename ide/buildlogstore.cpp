@@ -0,0 +1,305 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "buildlogstore.h"
+#include "appconfig.h"
+#include "ansitexttranslator.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QSet>
+#include <QtConcurrent>
+
+#include <cstring>
+
+static constexpr int INDEX_STRIDE = 256;
+static constexpr int SEARCH_CHUNK_LINES = 64 * INDEX_STRIDE;
+static constexpr int MAX_MATCHES = 10000;
+static constexpr int MAX_STORED_BUILDS = 20;
+
+static QString severityName(BuildDiagnostic::Severity s)
+{
+    switch (s) {
+    case BuildDiagnostic::Severity::Warning: return "warning";
+    case BuildDiagnostic::Severity::Note: return "note";
+    default: return "error";
+    }
+}
+
+static BuildDiagnostic::Severity severityFromName(const QString& s)
+{
+    if (s == "warning")
+        return BuildDiagnostic::Severity::Warning;
+    if (s == "note")
+        return BuildDiagnostic::Severity::Note;
+    return BuildDiagnostic::Severity::Error;
+}
+
+static QVector<qint64> readIndex(const QString& path)
+{
+    QVector<qint64> index;
+    QFile f(path);
+    if (f.open(QFile::ReadOnly)) {
+        QDataStream s(&f);
+        s >> index;
+    }
+    return index;
+}
+
+QString BuildLogStore::storePath(const QString &projectFile)
+{
+    auto hash = QCryptographicHash::hash(QFileInfo(projectFile).absoluteFilePath().toUtf8(),
+                                         QCryptographicHash::Sha1).toHex();
+    auto root = QDir(AppConfig::instance().workspacePath()).filePath("buildlogs");
+    return AppConfig::ensureExist(QDir(root).filePath(QString::fromLatin1(hash)));
+}
+
+QString BuildLogStore::newLogBase(const QString &projectFile)
+{
+    QDir dir(storePath(projectFile));
+    auto old = builds(projectFile);
+    for (const auto& log: old.mid(MAX_STORED_BUILDS - 1))
+        for (const auto& suffix: { ".json", ".diag.json", ".log", ".idx" })
+            QFile::remove(log.basePath + suffix);
+    return dir.filePath(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss-zzz"));
+}
+
+QList<BuildLogInfo> BuildLogStore::builds(const QString &projectFile)
+{
+    QList<BuildLogInfo> list;
+    QDir dir(storePath(projectFile));
+    for (const auto& info: dir.entryInfoList({ "*.json" }, QDir::Files, QDir::Name | QDir::Reversed)) {
+        if (info.fileName().endsWith(".diag.json"))
+            continue;
+        QFile f(info.absoluteFilePath());
+        if (!f.open(QFile::ReadOnly))
+            continue;
+        auto o = QJsonDocument::fromJson(f.readAll()).object();
+        BuildLogInfo log;
+        log.basePath = dir.filePath(info.completeBaseName());
+        log.target = o.value("target").toString();
+        log.started = QDateTime::fromString(o.value("started").toString(), Qt::ISODate);
+        log.finished = QDateTime::fromString(o.value("finished").toString(), Qt::ISODate);
+        log.exitCode = o.value("exitCode").toInt(-1);
+        log.lineCount = o.value("lines").toInt();
+        list.append(log);
+    }
+    return list;
+}
+
+QVector<BuildDiagnostic> BuildLogStore::diagnostics(const BuildLogInfo &log)
+{
+    QVector<BuildDiagnostic> list;
+    QFile f(log.basePath + ".diag.json");
+    if (!f.open(QFile::ReadOnly))
+        return list;
+    for (const auto& v: QJsonDocument::fromJson(f.readAll()).array()) {
+        auto o = v.toObject();
+        BuildDiagnostic d;
+        d.id = o.value("id").toInt();
+        d.parent = o.value("parent").toInt(-1);
+        d.file = o.value("file").toString();
+        d.line = o.value("line").toInt(-1);
+        d.column = o.value("column").toInt(-1);
+        d.severity = severityFromName(o.value("severity").toString());
+        d.message = o.value("message").toString();
+        d.outputLine = o.value("outputLine").toInt(-1);
+        list.append(d);
+    }
+    return list;
+}
+
+QFuture<QVector<BuildLogMatch>> BuildLogStore::search(const BuildLogInfo &log, const QRegularExpression &re)
+{
+    auto logPath = log.logPath();
+    auto indexPath = log.basePath + ".idx";
+    return QtConcurrent::run([logPath, indexPath, re]() {
+        QVector<BuildLogMatch> matches;
+        QFile file(logPath);
+        if (!file.open(QFile::ReadOnly))
+            return matches;
+        // The sparse index splits the log in chunks scanned in parallel
+        struct Chunk { int firstLine; qint64 begin; qint64 end; };
+        auto index = readIndex(indexPath);
+        if (index.isEmpty())
+            index.append(0);
+        QVector<Chunk> chunks;
+        constexpr int step = SEARCH_CHUNK_LINES / INDEX_STRIDE;
+        for (int i = 0; i < index.size(); i += step) {
+            auto end = i + step < index.size()? index.at(i + step) : file.size();
+            chunks.append({ i * INDEX_STRIDE, index.at(i), end });
+        }
+        std::function<QVector<BuildLogMatch>(const Chunk&)> scan = [logPath, re](const Chunk& c) {
+            QVector<BuildLogMatch> found;
+            QFile f(logPath);
+            if (c.end <= c.begin || !f.open(QFile::ReadOnly))
+                return found;
+            auto data = f.map(c.begin, c.end - c.begin);
+            if (!data)
+                return found;
+            auto ptr = reinterpret_cast<const char*>(data);
+            auto end = ptr + (c.end - c.begin);
+            int line = c.firstLine;
+            while (ptr < end && found.size() < MAX_MATCHES) {
+                auto nl = static_cast<const char*>(std::memchr(ptr, '\n', size_t(end - ptr)));
+                auto lineEnd = nl? nl : end;
+                auto textEnd = (lineEnd > ptr && *(lineEnd - 1) == '\r')? lineEnd - 1 : lineEnd;
+                auto text = QString::fromUtf8(ptr, int(textEnd - ptr));
+                if (std::memchr(ptr, '\x1b', size_t(textEnd - ptr)))
+                    text = AnsiTextTranslator::strip(text);
+                if (re.match(text).hasMatch())
+                    found.append({ line, text });
+                line++;
+                ptr = lineEnd + 1;
+            }
+            f.unmap(const_cast<uchar*>(data));
+            return found;
+        };
+        for (const auto& part: QtConcurrent::blockingMapped<QVector<QVector<BuildLogMatch>>>(chunks, scan)) {
+            matches += part;
+            if (matches.size() >= MAX_MATCHES) {
+                matches.resize(MAX_MATCHES);
+                break;
+            }
+        }
+        return matches;
+    });
+}
+
+void BuildLogStore::diffWarnings(const QVector<BuildDiagnostic> &before, const QVector<BuildDiagnostic> &after,
+                                 QVector<BuildDiagnostic> *added, QVector<BuildDiagnostic> *fixed)
+{
+    // Line numbers move with unrelated edits, file and message identify a warning
+    auto key = [](const BuildDiagnostic& d) { return d.file + QChar('\0') + d.message; };
+    auto keys = [&key](const QVector<BuildDiagnostic>& list) {
+        QSet<QString> set;
+        for (const auto& d: list)
+            if (d.severity == BuildDiagnostic::Severity::Warning)
+                set.insert(key(d));
+        return set;
+    };
+    auto beforeKeys = keys(before);
+    auto afterKeys = keys(after);
+    for (const auto& d: after)
+        if (d.severity == BuildDiagnostic::Severity::Warning && !beforeKeys.contains(key(d)))
+            added->append(d);
+    for (const auto& d: before)
+        if (d.severity == BuildDiagnostic::Severity::Warning && !afterKeys.contains(key(d)))
+            fixed->append(d);
+}
+
+BuildLogWriter::BuildLogWriter() = default;
+
+BuildLogWriter::~BuildLogWriter()
+{
+    if (isOpen())
+        close(-1);
+}
+
+bool BuildLogWriter::open(const QString &basePath, const QString &target)
+{
+    if (isOpen())
+        close(-1);
+    info = BuildLogInfo();
+    info.basePath = basePath;
+    info.target = target;
+    info.started = QDateTime::currentDateTime();
+    index.clear();
+    diagnostics.clear();
+    log.setFileName(info.logPath());
+    if (!log.open(QFile::WriteOnly | QFile::Truncate))
+        return false;
+    writeInfo(info);
+    return true;
+}
+
+void BuildLogWriter::append(const QByteArray &data)
+{
+    if (isOpen())
+        log.write(data);
+}
+
+void BuildLogWriter::addLine(qint64 offset)
+{
+    if (info.lineCount++ % INDEX_STRIDE == 0)
+        index.append(offset);
+}
+
+void BuildLogWriter::addDiagnostic(const BuildDiagnostic &d)
+{
+    diagnostics.append(d);
+}
+
+void BuildLogWriter::close(int exitCode)
+{
+    if (!isOpen())
+        return;
+    log.close();
+    info.finished = QDateTime::currentDateTime();
+    info.exitCode = exitCode;
+
+    QSaveFile idx(info.basePath + ".idx");
+    if (idx.open(QFile::WriteOnly)) {
+        QDataStream s(&idx);
+        s << index;
+        idx.commit();
+    }
+
+    QJsonArray array;
+    for (const auto& d: diagnostics)
+        array.append(QJsonObject{
+            { "id", d.id },
+            { "parent", d.parent },
+            { "file", d.file },
+            { "line", d.line },
+            { "column", d.column },
+            { "severity", severityName(d.severity) },
+            { "message", d.message },
+            { "outputLine", d.outputLine },
+        });
+    QSaveFile diag(info.basePath + ".diag.json");
+    if (diag.open(QFile::WriteOnly)) {
+        diag.write(QJsonDocument(array).toJson(QJsonDocument::Compact));
+        diag.commit();
+    }
+    writeInfo(info);
+    index.clear();
+    diagnostics.clear();
+}
+
+void BuildLogWriter::writeInfo(const BuildLogInfo &i)
+{
+    QJsonObject o{
+        { "target", i.target },
+        { "started", i.started.toString(Qt::ISODate) },
+        { "lines", i.lineCount },
+        { "exitCode", i.exitCode },
+    };
+    if (i.finished.isValid())
+        o.insert("finished", i.finished.toString(Qt::ISODate));
+    QSaveFile f(i.basePath + ".json");
+    if (f.open(QFile::WriteOnly)) {
+        f.write(QJsonDocument(o).toJson());
+        f.commit();
+    }
+}
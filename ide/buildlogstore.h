@@ -0,0 +1,80 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef BUILDLOGSTORE_H
+#define BUILDLOGSTORE_H
+
+#include "buildoutputparser.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QFuture>
+#include <QRegularExpression>
+#include <QVector>
+
+struct BuildLogInfo {
+    QString basePath; // Without extension, .log .idx .json and .diag.json are side by side
+    QString target;
+    QDateTime started;
+    QDateTime finished;
+    int exitCode = -1;
+    int lineCount = 0;
+
+    QString logPath() const { return basePath + ".log"; }
+};
+
+struct BuildLogMatch {
+    int line; // Zero based
+    QString text;
+};
+
+class BuildLogStore
+{
+public:
+    static QString storePath(const QString& projectFile);
+    static QString newLogBase(const QString& projectFile);
+    static QList<BuildLogInfo> builds(const QString& projectFile);
+    static QVector<BuildDiagnostic> diagnostics(const BuildLogInfo& log);
+    static QFuture<QVector<BuildLogMatch>> search(const BuildLogInfo& log, const QRegularExpression& re);
+    static void diffWarnings(const QVector<BuildDiagnostic>& before, const QVector<BuildDiagnostic>& after,
+                             QVector<BuildDiagnostic> *added, QVector<BuildDiagnostic> *fixed);
+};
+
+class BuildLogWriter
+{
+public:
+    BuildLogWriter();
+    ~BuildLogWriter();
+
+    bool open(const QString& basePath, const QString& target);
+    bool isOpen() const { return log.isOpen(); }
+    void append(const QByteArray& data);
+    void addLine(qint64 offset);
+    void addDiagnostic(const BuildDiagnostic& d);
+    void close(int exitCode);
+
+private:
+    void writeInfo(const BuildLogInfo& info);
+
+    BuildLogInfo info;
+    QFile log;
+    QVector<qint64> index;
+    QVector<BuildDiagnostic> diagnostics;
+};
+
+#endif // BUILDLOGSTORE_H
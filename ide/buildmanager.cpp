@@ -20,7 +20,11 @@
 #include "buildmanager.h"
 #include "processmanager.h"
 #include "projectmanager.h"
+#include "buildtimeline.h"
+#include "jobservergovernor.h"
+#include "compilecache.h"
 
+#include <QFile>
 #include <QFileInfo>
 
 #include <QThread>
@@ -28,36 +32,253 @@
 
 const QString BuildManager::PROCESS_NAME = "makeBuild";
 
+static constexpr int MAX_FINISHED_ENTRIES = 20;
+
 static int getOptimalNumberOfJobs()
 {
     return QThread::idealThreadCount();
 }
 
+static int budgetOfJobs()
+{
+    auto &c = AppConfig::instance();
+    return c.numberOfJobsOptimal()? getOptimalNumberOfJobs() : c.numberOfJobs();
+}
+
 BuildManager::BuildManager(ProjectManager *_proj, ProcessManager *_pman, QObject *parent) :
     QObject(parent),
     proj(_proj),
-    pman(_pman)
+    pman(_pman),
+    governor(new JobServerGovernor(this))
 {
-    pman->setErrorHandler(PROCESS_NAME, [](QProcess *proc, QProcess::ProcessError err) {
-        // TODO Implement this (maybe unnecesary?)
-        Q_UNUSED(proc)
-        Q_UNUSED(err)
-    });
-    pman->setTerminationHandler(PROCESS_NAME, [this](QProcess *proc, int code, QProcess::ExitStatus status) {
-        emit buildTerminated(code, status == QProcess::NormalExit? tr("Exit normal") : proc->errorString());
-    });
 }
 
-void BuildManager::startBuild(const QString &target)
+bool BuildManager::isBusy() const
 {
+    for (const auto& e: queue)
+        if (!e.isDone())
+            return true;
+    return false;
+}
+
+int BuildManager::startBuild(const QString &target)
+{
+    QList<int> after;
+    for (const auto& e: queue)
+        if (!e.isDone())
+            after.append(e.id);
+    return enqueue(target, after);
+}
+
+int BuildManager::startParallelBuild(const QString &target)
+{
+    return enqueue(target, {});
+}
+
+int BuildManager::enqueue(const QString &target, const QList<int> &after)
+{
+    if (!sessionActive)
+        startSession(target);
+    Entry e;
+    e.id = nextId++;
+    e.target = target;
+    e.after = after;
+    queue.append(e);
+    emit queueChanged();
+    schedule();
+    return e.id;
+}
+
+void BuildManager::cancel(int id)
+{
+    auto e = find(id);
+    if (!e || e->isDone())
+        return;
+    if (e->state == State::Queued) {
+        e->state = State::Canceled;
+        e->finished = QDateTime::currentDateTime();
+        emit queueChanged();
+        schedule();
+    } else {
+        canceling.insert(id);
+        pman->terminate(processName(id), true);
+    }
+}
+
+void BuildManager::cancelBuild()
+{
+    for (auto& e: queue) {
+        if (e.state == State::Queued) {
+            e.state = State::Canceled;
+            e.finished = QDateTime::currentDateTime();
+        }
+    }
+    emit queueChanged();
+    QList<int> running;
+    for (const auto& e: queue)
+        if (e.state == State::Running)
+            running.append(e.id);
+    for (auto id: running)
+        cancel(id);
+    // External tools run on the plain build process
+    if (pman->isRunning(PROCESS_NAME))
+        pman->terminate(PROCESS_NAME, true);
+    schedule();
+}
+
+BuildManager::Entry *BuildManager::find(int id)
+{
+    for (auto& e: queue)
+        if (e.id == id)
+            return &e;
+    return nullptr;
+}
+
+void BuildManager::startSession(const QString &target)
+{
+    // Finished entries of older sessions are kept for a while to show them
+    while (queue.size() > MAX_FINISHED_ENTRIES && queue.first().isDone())
+        queue.removeFirst();
+
     auto &c = AppConfig::instance();
-    auto nJobs = c.numberOfJobsOptimal()? getOptimalNumberOfJobs() : c.numberOfJobs();
-    auto params = QStringList{ "-j", QString("%1").arg(nJobs), "-f", proj->projectFile(), target };
-    pman->start(PROCESS_NAME, "make", params, { { "LC_ALL", "C" }, { "LANG", "C" } }, proj->projectPath());
+    sessionActive = true;
+    sessionCode = 0;
+    sessionError = tr("Exit normal");
+    sessionEnv = { { "LC_ALL", "C" }, { "LANG", "C" } };
+    sessionParams.clear();
+    auto makeflags = c.numberOfJobsAdaptive()? governor->start(budgetOfJobs()) : QString();
+    if (!makeflags.isEmpty()) {
+        // All makes join the jobserver we run instead of creating their own, -l backs off on load
+        sessionParams << "-l" << QString::number(QThread::idealThreadCount());
+        sessionEnv.insert("MAKEFLAGS", makeflags);
+    }
+    trace.clear();
+    cacheActive = false;
+    auto wrapper = c.buildInstrumentation() || c.compileCacheEnabled()? BuildTimeline::wrapperPath() : QString();
+    if (!wrapper.isEmpty()) {
+        // Every recipe line goes through the wrapper, sub makes inherit SHELL
+        sessionParams.prepend(QString("SHELL=%1").arg(wrapper));
+        // The command line SHELL hides the one of the makefile, the wrapper runs it
+        if (!proj->makeShell().isEmpty())
+            sessionEnv.insert("EMBEDDED_IDE_REAL_SHELL", proj->makeShell());
+        if (c.buildInstrumentation()) {
+            trace = BuildTimeline::tracePath(proj->projectFile());
+            QFile::remove(trace);
+            sessionEnv.insert("EMBEDDED_IDE_BUILD_TRACE", trace);
+        }
+        if (c.compileCacheEnabled()) {
+            cacheActive = true;
+            QFile::remove(CompileCache::statsPath());
+            sessionEnv.insert("EMBEDDED_IDE_COMPILE_CACHE", CompileCache::path());
+            sessionEnv.insert("EMBEDDED_IDE_COMPILE_CACHE_STATS", CompileCache::statsPath());
+        }
+    }
     emit buildStarted(target);
 }
 
-void BuildManager::cancelBuild()
+void BuildManager::schedule()
+{
+    bool changed = false;
+    QList<Entry*> ready;
+    int running = 0;
+    // Failures propagate to the entries waiting for them
+    for (bool again = true; again;) {
+        again = false;
+        for (auto& e: queue) {
+            if (e.state != State::Queued)
+                continue;
+            for (auto id: e.after) {
+                auto dep = find(id);
+                if (dep && (dep->state == State::Failed || dep->state == State::Canceled)) {
+                    e.state = State::Canceled;
+                    e.finished = QDateTime::currentDateTime();
+                    again = changed = true;
+                    break;
+                }
+            }
+        }
+    }
+    for (auto& e: queue) {
+        if (e.state == State::Running)
+            running++;
+        if (e.state != State::Queued)
+            continue;
+        bool waiting = false;
+        for (auto id: e.after) {
+            auto dep = find(id);
+            if (dep && dep->state != State::Succeeded)
+                waiting = true;
+        }
+        if (!waiting)
+            ready.append(&e);
+    }
+    if (!ready.isEmpty()) {
+        // Without the jobserver the budget is split when the makes start
+        int jobs = qMax(1, budgetOfJobs() / (running + ready.size()));
+        for (auto e: ready)
+            if (e->state == State::Queued) // A failed start schedules again
+                startEntry(*e, jobs);
+        changed = true;
+    }
+    if (changed)
+        emit queueChanged();
+    if (sessionActive && !isBusy()) {
+        sessionActive = false;
+        governor->stop();
+        emit buildTerminated(sessionCode, sessionError);
+    }
+}
+
+void BuildManager::startEntry(Entry &e, int jobs)
+{
+    int id = e.id;
+    auto name = processName(id);
+    auto proc = pman->processFor(name);
+    proc->setProcessChannelMode(QProcess::MergedChannels);
+    connect(proc, &QProcess::readyRead, this, [this, id, proc]() { emit entryOutput(id, proc->readAll()); });
+    pman->setStartupHandler(name, [this, id](QProcess *p) {
+        auto e = find(id);
+        if (e)
+            e->pid = p->processId();
+        if (governor->isRunning())
+            governor->attach(p->processId());
+    });
+    pman->setTerminationHandler(name, [this, id](QProcess *p, int code, QProcess::ExitStatus status) {
+        finishEntry(id, code, status == QProcess::NormalExit? tr("Exit normal") : p->errorString());
+    });
+    pman->setErrorHandler(name, [this, id](QProcess *p, QProcess::ProcessError err) {
+        if (err == QProcess::FailedToStart)
+            finishEntry(id, -1, p->errorString());
+    });
+
+    e.state = State::Running;
+    e.started = QDateTime::currentDateTime();
+    e.jobs = governor->isRunning()? 0 : jobs;
+    auto params = sessionParams;
+    if (!governor->isRunning())
+        params << "-j" << QString::number(jobs);
+    params << "-f" << proj->projectFile() << e.target;
+    emit entryStarted(id, e.target);
+    governor->setInheritable(true);
+    pman->start(name, "make", params, sessionEnv, proj->projectPath());
+    governor->setInheritable(false);
+}
+
+void BuildManager::finishEntry(int id, int code, const QString &error)
 {
-    pman->terminate(BuildManager::PROCESS_NAME, true);
+    auto e = find(id);
+    if (!e || e->isDone())
+        return;
+    governor->detach(e->pid);
+    bool canceled = canceling.remove(id);
+    e->exitCode = code;
+    e->finished = QDateTime::currentDateTime();
+    e->state = canceled? State::Canceled : code == 0? State::Succeeded : State::Failed;
+    if (e->state != State::Succeeded && sessionCode == 0) {
+        sessionCode = code? code : -1;
+        sessionError = error;
+    }
+    emit entryFinished(id, code, error);
+    pman->processFor(processName(id))->deleteLater();
+    schedule();
 }
@@ -19,8 +19,12 @@
 #ifndef BUILDMANAGER_H
 #define BUILDMANAGER_H
 
+#include <QDateTime>
+#include <QHash>
 #include <QObject>
+#include <QSet>
 
+class JobServerGovernor;
 class ProcessManager;
 class ProjectManager;
 
@@ -29,21 +33,72 @@ class BuildManager : public QObject
     Q_OBJECT
     Q_DISABLE_COPY(BuildManager)
 public:
+    enum class State { Queued, Running, Succeeded, Failed, Canceled };
+
+    struct Entry {
+        int id;
+        QString target;
+        QList<int> after; // Entries that must succeed first
+        State state = State::Queued;
+        int exitCode = 0;
+        int jobs = 0;  // Own -j share, 0 when the makes share the jobserver
+        qint64 pid = 0;
+        QDateTime started;
+        QDateTime finished;
+
+        bool isDone() const { return state != State::Queued && state != State::Running; }
+    };
+
     static const QString PROCESS_NAME;
 
     explicit BuildManager(ProjectManager *_proj, ProcessManager *_pman, QObject *parent = nullptr);
 
+    QString traceFile() const { return trace; }
+    bool compileCacheActive() const { return cacheActive; }
+
+    const QList<Entry>& entries() const { return queue; }
+    bool isBusy() const;
+
 signals:
+    // The queue starts working and when it drains
     void buildStarted(const QString& target);
     void buildTerminated(int code, const QString& error);
 
+    void entryStarted(int id, const QString& target);
+    void entryOutput(int id, const QByteArray& data);
+    void entryFinished(int id, int code, const QString& error);
+    void queueChanged();
+
 public slots:
-    void startBuild(const QString& target);
+    // Runs after the entries still pending, one after the other
+    int startBuild(const QString& target);
+    // Runs as soon as the job budget allows, next to the others
+    int startParallelBuild(const QString& target);
+    int enqueue(const QString& target, const QList<int>& after);
+    void cancel(int id);
     void cancelBuild();
 
 private:
+    Entry *find(int id);
+    void startSession(const QString& target);
+    void schedule();
+    void startEntry(Entry& e, int jobs);
+    void finishEntry(int id, int code, const QString& error);
+    static QString processName(int id) { return QString("%1#%2").arg(PROCESS_NAME).arg(id); }
+
     ProjectManager *proj;
     ProcessManager *pman;
+    QString trace;
+    bool cacheActive = false;
+    JobServerGovernor *governor;
+    QList<Entry> queue;
+    QHash<QString, QString> sessionEnv;
+    QStringList sessionParams;
+    QSet<int> canceling;
+    int nextId = 1;
+    int sessionCode = 0;
+    QString sessionError;
+    bool sessionActive = false;
 };
 
 #endif // BUILDMANAGER_H
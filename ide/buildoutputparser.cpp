@@ -0,0 +1,161 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "buildoutputparser.h"
+#include "buildlogstore.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QRegularExpression>
+
+#include <cstring>
+
+static constexpr int BATCH_INTERVAL = 30;
+static constexpr int BATCH_LINES = 512;
+
+BuildOutputParser::BuildOutputParser(int id, QObject *parent) :
+    QObject(parent),
+    buildId(id),
+    log(new BuildLogWriter),
+    batchTimer(new QTimer(this))
+{
+    qRegisterMetaType<BuildOutputBatch>();
+    batch.buildId = buildId;
+    batchTimer->setSingleShot(true);
+    batchTimer->setInterval(BATCH_INTERVAL);
+    connect(batchTimer, &QTimer::timeout, this, &BuildOutputParser::emitBatch);
+}
+
+BuildOutputParser::~BuildOutputParser()
+{
+}
+
+void BuildOutputParser::reset(const QString &buildPath, const QString &logBase, const QString &target)
+{
+    rootPath = buildPath;
+    directoryStack.clear();
+    splitter.reset();
+    ansi.reset();
+    lineNumber = 0;
+    if (logBase.isEmpty())
+        log->close(-1);
+    else
+        log->open(logBase, target);
+    batch = BuildOutputBatch();
+    batch.buildId = buildId;
+    batchTimer->stop();
+    nextId = 0;
+    lastParent = -1;
+}
+
+void BuildOutputParser::pushData(const QByteArray &data)
+{
+    log->append(data);
+    for (const auto& line: splitter.push(data)) {
+        log->addLine(line.offset);
+        parseLine(line);
+    }
+    if (batch.lines.size() >= BATCH_LINES)
+        emitBatch();
+    else if (!batch.isEmpty() && !batchTimer->isActive())
+        batchTimer->start();
+}
+
+void BuildOutputParser::finish(int exitCode)
+{
+    for (const auto& line: splitter.flush()) {
+        log->addLine(line.offset);
+        parseLine(line);
+    }
+    emitBatch();
+    log->close(exitCode);
+}
+
+void BuildOutputParser::emitBatch()
+{
+    batchTimer->stop();
+    if (batch.isEmpty())
+        return;
+    emit batchReady(batch);
+    batch = BuildOutputBatch();
+    batch.buildId = buildId;
+}
+
+void BuildOutputParser::parseLine(const LineSplitter::LineView &view)
+{
+    static const QRegularExpression dirRe(R"(^make(?:\[(\d+)\])?: (Entering|Leaving) directory [`'](.*)'$)");
+    static const QRegularExpression errRe(
+        R"(^(?<file>.+?):(?<line>\d+):(?:(?<col>\d+):)?\s*(?:(?<sev>fatal error|error|warning|note):\s*)?(?<msg>.*)$)");
+
+    int outputLine = lineNumber++;
+    auto line = view.toString();
+    AnsiSpanList spans;
+    // Colored diagnostics are parsed without their escapes
+    if (ansi.hasStyle() || std::memchr(view.data, '\x1b', size_t(view.size)))
+        spans = ansi.translate(line);
+    batch.lines.append(line);
+    batch.lineDiagnostic.append(-1);
+    batch.lineSpans.append(spans);
+
+    // Cheap checks first, most of the lines are compiler invocations
+    if (line.startsWith(QLatin1String("make"))) {
+        auto m = dirRe.match(line);
+        if (m.hasMatch()) {
+            int level = qMax(1, m.captured(1).toInt());
+            if (m.captured(2) == QLatin1String("Entering")) {
+                directoryStack.resize(level);
+                directoryStack[level - 1] = m.captured(3);
+            } else {
+                directoryStack.resize(level - 1);
+            }
+        }
+        return;
+    }
+    if (!line.contains(':'))
+        return;
+    auto m = errRe.match(line);
+    if (!m.hasMatch())
+        return;
+    // Include context, "In file included from a.h:3:" and its "   from b.c:2:" lines
+    auto file = m.captured("file");
+    if (file.at(0).isSpace() || file.startsWith(QLatin1String("In file included from ")))
+        return;
+    BuildDiagnostic d;
+    d.id = nextId++;
+    d.file = file;
+    if (QFileInfo(d.file).isRelative()) {
+        auto dir = directoryStack.isEmpty() || directoryStack.last().isEmpty()? rootPath : directoryStack.last();
+        d.file = QDir::cleanPath(QDir(dir).absoluteFilePath(d.file));
+    }
+    d.line = m.captured("line").toInt();
+    d.column = m.captured("col").isEmpty()? -1 : m.captured("col").toInt();
+    auto sev = m.captured("sev");
+    if (sev == QLatin1String("warning"))
+        d.severity = BuildDiagnostic::Severity::Warning;
+    else if (sev == QLatin1String("note") || sev.isEmpty()) // Like "required from here"
+        d.severity = BuildDiagnostic::Severity::Note;
+    d.message = m.captured("msg");
+    d.outputLine = outputLine;
+    if (d.severity == BuildDiagnostic::Severity::Note)
+        d.parent = lastParent;
+    else
+        lastParent = d.id;
+    batch.lineDiagnostic.last() = batch.diagnostics.size();
+    batch.diagnostics.append(d);
+    log->addDiagnostic(d);
+}
@@ -0,0 +1,95 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef BUILDOUTPUTPARSER_H
+#define BUILDOUTPUTPARSER_H
+
+#include <QElapsedTimer>
+#include <QMetaType>
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+
+#include "ansitexttranslator.h"
+#include "linesplitter.h"
+
+#include <memory>
+
+class BuildLogWriter;
+
+struct BuildDiagnostic {
+    enum class Severity { Error, Warning, Note };
+
+    int id = -1;
+    int parent = -1; // Notes refer to the error or warning they belong to
+    QString file;
+    int line = -1;
+    int column = -1;
+    Severity severity = Severity::Error;
+    QString message;
+    int outputLine = -1; // Zero based line in the build output
+};
+
+struct BuildOutputBatch {
+    QStringList lines;
+    QVector<int> lineDiagnostic; // Index in diagnostics for each line or -1
+    QVector<AnsiSpanList> lineSpans; // Empty for lines without colors
+    QVector<BuildDiagnostic> diagnostics;
+    int buildId = 0;
+
+    bool isEmpty() const { return lines.isEmpty(); }
+};
+
+Q_DECLARE_METATYPE(BuildOutputBatch)
+
+class BuildOutputParser : public QObject
+{
+    Q_OBJECT
+public:
+    explicit BuildOutputParser(int id = 0, QObject *parent = nullptr);
+    ~BuildOutputParser() override;
+
+signals:
+    void batchReady(const BuildOutputBatch& batch);
+
+public slots:
+    void reset(const QString& buildPath, const QString& logBase = QString(), const QString& target = QString());
+    void pushData(const QByteArray& data);
+    void finish(int exitCode = 0);
+
+private slots:
+    void emitBatch();
+
+private:
+    void parseLine(const LineSplitter::LineView& view);
+
+    int buildId;
+    QString rootPath;
+    QVector<QString> directoryStack;
+    LineSplitter splitter;
+    AnsiTextTranslator ansi;
+    int lineNumber = 0;
+    std::unique_ptr<BuildLogWriter> log;
+    QTimer *batchTimer; // A child, it follows the parser to its thread
+    BuildOutputBatch batch;
+    int nextId = 0;
+    int lastParent = -1;
+};
+
+#endif // BUILDOUTPUTPARSER_H
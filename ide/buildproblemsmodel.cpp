@@ -0,0 +1,157 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "buildproblemsmodel.h"
+
+#include <QColor>
+#include <QFileInfo>
+
+// Top level rows have a zero internal id, notes store the row of their problem plus one
+
+BuildProblemsModel::BuildProblemsModel(QObject *parent) :
+    QAbstractItemModel(parent)
+{
+}
+
+BuildProblemsModel::~BuildProblemsModel()
+{
+}
+
+const BuildDiagnostic *BuildProblemsModel::diagnostic(const QModelIndex &index) const
+{
+    if (!index.isValid())
+        return nullptr;
+    if (index.internalId() == 0)
+        return &problems.at(index.row()).diagnostic;
+    return &problems.at(static_cast<int>(index.internalId() - 1)).notes.at(index.row());
+}
+
+QModelIndex BuildProblemsModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (!hasIndex(row, column, parent))
+        return QModelIndex();
+    if (!parent.isValid())
+        return createIndex(row, column, quintptr(0));
+    return createIndex(row, column, quintptr(parent.row() + 1));
+}
+
+QModelIndex BuildProblemsModel::parent(const QModelIndex &child) const
+{
+    if (!child.isValid() || child.internalId() == 0)
+        return QModelIndex();
+    return createIndex(static_cast<int>(child.internalId() - 1), 0, quintptr(0));
+}
+
+int BuildProblemsModel::rowCount(const QModelIndex &parent) const
+{
+    if (!parent.isValid())
+        return problems.size();
+    if (parent.internalId() == 0 && parent.column() == 0)
+        return problems.at(parent.row()).notes.size();
+    return 0;
+}
+
+int BuildProblemsModel::columnCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent);
+    return ColumnCount;
+}
+
+QVariant BuildProblemsModel::data(const QModelIndex &index, int role) const
+{
+    auto d = diagnostic(index);
+    if (!d)
+        return QVariant();
+    switch (role) {
+    case Qt::DisplayRole:
+        switch (index.column()) {
+        case MessageColumn: return d->message;
+        case FileColumn: return QFileInfo(d->file).fileName();
+        case LineColumn: return d->line;
+        }
+        break;
+    case Qt::ToolTipRole:
+        return QString("%1:%2").arg(d->file).arg(d->line);
+    case Qt::ForegroundRole:
+        if (index.column() == MessageColumn) {
+            switch (d->severity) {
+            case BuildDiagnostic::Severity::Error: return QColor(Qt::red);
+            case BuildDiagnostic::Severity::Warning: return QColor(Qt::darkYellow);
+            case BuildDiagnostic::Severity::Note: return QColor(Qt::darkGray);
+            }
+        }
+        break;
+    }
+    return QVariant();
+}
+
+QVariant BuildProblemsModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return QVariant();
+    switch (section) {
+    case MessageColumn: return tr("Message");
+    case FileColumn: return tr("File");
+    case LineColumn: return tr("Line");
+    }
+    return QVariant();
+}
+
+void BuildProblemsModel::clear()
+{
+    beginResetModel();
+    problems.clear();
+    rowOfId.clear();
+    errors = 0;
+    warnings = 0;
+    endResetModel();
+}
+
+void BuildProblemsModel::appendDiagnostics(const QVector<BuildDiagnostic> &list, int source)
+{
+    // New problems of a batch are inserted at once, with the notes already attached
+    QVector<Problem> added;
+    auto flushAdded = [this, &added]() {
+        if (added.isEmpty())
+            return;
+        beginInsertRows(QModelIndex(), problems.size(), problems.size() + added.size() - 1);
+        problems += added;
+        added.clear();
+        endInsertRows();
+    };
+    for(const auto& d: list) {
+        int parentRow = d.parent != -1? rowOfId.value(qMakePair(source, d.parent), -1) : -1;
+        if (parentRow >= problems.size()) {
+            added[parentRow - problems.size()].notes.append(d);
+        } else if (parentRow != -1) {
+            flushAdded();
+            auto& notes = problems[parentRow].notes;
+            beginInsertRows(index(parentRow, 0), notes.size(), notes.size());
+            notes.append(d);
+            endInsertRows();
+        } else {
+            rowOfId.insert(qMakePair(source, d.id), problems.size() + added.size());
+            added.append(Problem{ d, {} });
+            if (d.severity == BuildDiagnostic::Severity::Error)
+                errors++;
+            else if (d.severity == BuildDiagnostic::Severity::Warning)
+                warnings++;
+        }
+    }
+    flushAdded();
+}
@@ -0,0 +1,64 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef BUILDPROBLEMSMODEL_H
+#define BUILDPROBLEMSMODEL_H
+
+#include "buildoutputparser.h"
+
+#include <QAbstractItemModel>
+#include <QHash>
+
+class BuildProblemsModel : public QAbstractItemModel
+{
+    Q_OBJECT
+public:
+    enum Column { MessageColumn, FileColumn, LineColumn, ColumnCount };
+
+    explicit BuildProblemsModel(QObject *parent = nullptr);
+    ~BuildProblemsModel() override;
+
+    const BuildDiagnostic *diagnostic(const QModelIndex& index) const;
+    int errorCount() const { return errors; }
+    int warningCount() const { return warnings; }
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+public slots:
+    void clear();
+    // Diagnostic ids are unique inside a source, one per concurrent build
+    void appendDiagnostics(const QVector<BuildDiagnostic>& list, int source = 0);
+
+private:
+    struct Problem {
+        BuildDiagnostic diagnostic;
+        QVector<BuildDiagnostic> notes;
+    };
+
+    QVector<Problem> problems;
+    QHash<QPair<int, int>, int> rowOfId;
+    int errors = 0;
+    int warnings = 0;
+};
+
+#endif // BUILDPROBLEMSMODEL_H
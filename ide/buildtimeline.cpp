@@ -0,0 +1,150 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "buildtimeline.h"
+#include "buildlogstore.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QSaveFile>
+
+#include <algorithm>
+
+static constexpr int HISTORY_SIZE = 10;
+
+QString BuildTimeline::wrapperPath()
+{
+#ifdef Q_OS_WIN
+    const QString name = "buildwrapper.exe";
+#else
+    const QString name = "buildwrapper";
+#endif
+    auto path = QDir(QCoreApplication::applicationDirPath()).absoluteFilePath(name);
+    return QFileInfo(path).isExecutable()? path : QString();
+}
+
+QString BuildTimeline::tracePath(const QString &projectFile)
+{
+    return QDir(BuildLogStore::storePath(projectFile)).filePath("current.trace");
+}
+
+QVector<BuildStep> BuildTimeline::load(const QString &tracePath, const QString &buildPath)
+{
+    static const QRegularExpression compileRe(R"((?:^|\s)-c(?:\s|$))");
+    static const QRegularExpression sourceRe(R"((?:^|\s)([^\s'"]+\.(?:c|cc|cpp|cxx|c\+\+|s|S|sx|asm))(?=\s|$))");
+    static const QRegularExpression outputRe(R"((?:^|\s)-o\s*([^\s'"]+))");
+
+    QVector<BuildStep> steps;
+    QFile f(tracePath);
+    if (!f.open(QFile::ReadOnly))
+        return steps;
+    while (!f.atEnd()) {
+        auto o = QJsonDocument::fromJson(f.readLine()).object();
+        auto cmd = o.value("cmd").toString();
+        // Recursive makes run their recipes in subdirectories
+        QDir base(o.value("cwd").toString(buildPath));
+        // Only compile and link steps, mkdir and echo lines are noise
+        BuildStep s;
+        if (compileRe.match(cmd).hasMatch()) {
+            auto m = sourceRe.match(cmd);
+            if (!m.hasMatch())
+                continue;
+            s.kind = BuildStep::Kind::Compile;
+            s.target = QDir::cleanPath(base.absoluteFilePath(m.captured(1)));
+        } else {
+            auto m = outputRe.match(cmd);
+            if (!m.hasMatch())
+                continue;
+            s.kind = BuildStep::Kind::Link;
+            s.target = QDir::cleanPath(base.absoluteFilePath(m.captured(1)));
+        }
+        s.start = qint64(o.value("start").toDouble());
+        s.end = qint64(o.value("end").toDouble());
+        s.peakRss = qint64(o.value("rss").toDouble(-1));
+        s.exitCode = o.value("exit").toInt();
+        s.lane = 0;
+        s.command = cmd;
+        steps.append(s);
+    }
+
+    // Greedy packing in lanes, one lane per job running at the same time
+    std::sort(steps.begin(), steps.end(), [](const BuildStep& a, const BuildStep& b) { return a.start < b.start; });
+    QVector<qint64> laneEnd;
+    for (auto& s: steps) {
+        auto it = std::find_if(laneEnd.begin(), laneEnd.end(), [&s](qint64 e) { return e <= s.start; });
+        if (it == laneEnd.end()) {
+            s.lane = laneEnd.size();
+            laneEnd.append(s.end);
+        } else {
+            s.lane = int(it - laneEnd.begin());
+            *it = s.end;
+        }
+    }
+    return steps;
+}
+
+static QString historyPath(const QString& projectFile)
+{
+    return QDir(BuildLogStore::storePath(projectFile)).filePath("compiletimes.json");
+}
+
+QHash<QString, QVector<int>> BuildTimeline::history(const QString &projectFile)
+{
+    QHash<QString, QVector<int>> h;
+    QFile f(historyPath(projectFile));
+    if (!f.open(QFile::ReadOnly))
+        return h;
+    auto o = QJsonDocument::fromJson(f.readAll()).object();
+    for (auto it = o.constBegin(); it != o.constEnd(); ++it) {
+        QVector<int> times;
+        for (const auto& v: it.value().toArray())
+            times.append(v.toInt());
+        h.insert(it.key(), times);
+    }
+    return h;
+}
+
+void BuildTimeline::appendHistory(const QString &projectFile, const QVector<BuildStep> &steps)
+{
+    auto h = history(projectFile);
+    for (const auto& s: steps) {
+        if (s.exitCode != 0)
+            continue;
+        auto& times = h[s.target];
+        times.append(int(s.duration()));
+        if (times.size() > HISTORY_SIZE)
+            times.remove(0, times.size() - HISTORY_SIZE);
+    }
+    QJsonObject o;
+    for (auto it = h.constBegin(); it != h.constEnd(); ++it) {
+        QJsonArray a;
+        for (auto t: it.value())
+            a.append(t);
+        o.insert(it.key(), a);
+    }
+    QSaveFile f(historyPath(projectFile));
+    if (f.open(QFile::WriteOnly)) {
+        f.write(QJsonDocument(o).toJson(QJsonDocument::Compact));
+        f.commit();
+    }
+}
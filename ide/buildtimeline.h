@@ -0,0 +1,54 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef BUILDTIMELINE_H
+#define BUILDTIMELINE_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+struct BuildStep {
+    enum class Kind { Compile, Link };
+
+    qint64 start; // Milliseconds since epoch
+    qint64 end;
+    qint64 peakRss; // Kilobytes, -1 if unknown
+    int exitCode;
+    int lane;
+    Kind kind;
+    QString target; // Source for compiles, output for links
+    QString command;
+
+    qint64 duration() const { return end - start; }
+};
+
+class BuildTimeline
+{
+public:
+    static QString wrapperPath();
+    static QString tracePath(const QString& projectFile);
+
+    static QVector<BuildStep> load(const QString& tracePath, const QString& buildPath);
+
+    // Durations in milliseconds of the last builds for each target, oldest first
+    static QHash<QString, QVector<int>> history(const QString& projectFile);
+    static void appendHistory(const QString& projectFile, const QVector<BuildStep>& steps);
+};
+
+#endif // BUILDTIMELINE_H
@@ -0,0 +1,198 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "buildtimelineview.h"
+
+#include <QFileInfo>
+#include <QHeaderView>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QScrollArea>
+#include <QSplitter>
+#include <QToolTip>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+#include <algorithm>
+
+static constexpr int LANE_HEIGHT = 18;
+static constexpr int AXIS_HEIGHT = 16;
+
+class BuildTimelineView::Chart : public QWidget
+{
+public:
+    explicit Chart(BuildTimelineView *view) : QWidget(view), view(view) {
+        setMouseTracking(true);
+    }
+
+    void setSteps(const QVector<BuildStep>& s) {
+        steps = s;
+        lanes = 0;
+        t0 = steps.isEmpty()? 0 : steps.first().start;
+        t1 = t0;
+        for (const auto& st: steps) {
+            lanes = qMax(lanes, st.lane + 1);
+            t1 = qMax(t1, st.end);
+        }
+        setMinimumHeight(AXIS_HEIGHT + lanes * LANE_HEIGHT);
+        update();
+    }
+
+    const BuildStep *stepAt(const QPoint& p) const {
+        if (p.y() < AXIS_HEIGHT)
+            return nullptr;
+        int lane = (p.y() - AXIS_HEIGHT) / LANE_HEIGHT;
+        auto t = timeAt(p.x());
+        for (const auto& s: steps)
+            if (s.lane == lane && s.start <= t && t <= s.end)
+                return &s;
+        return nullptr;
+    }
+
+protected:
+    void paintEvent(QPaintEvent *) override {
+        QPainter p(this);
+        p.fillRect(rect(), palette().base());
+        if (steps.isEmpty())
+            return;
+        auto span = qMax<qint64>(1, t1 - t0);
+        // One tick per second up to ten ticks, then coarser
+        qint64 tick = 1000;
+        while (span / tick > 10)
+            tick *= 2;
+        p.setPen(palette().mid().color());
+        for (qint64 t = 0; t <= span; t += tick) {
+            int x = xAt(t0 + t);
+            p.drawLine(x, 0, x, height());
+            p.drawText(x + 2, AXIS_HEIGHT - 4, QString("%1s").arg(t / 1000));
+        }
+        for (const auto& s: steps) {
+            QRect r(xAt(s.start), AXIS_HEIGHT + s.lane * LANE_HEIGHT + 1,
+                    qMax(1, xAt(s.end) - xAt(s.start)), LANE_HEIGHT - 2);
+            auto color = s.exitCode != 0? QColor(Qt::red) :
+                         s.kind == BuildStep::Kind::Link? QColor(230, 150, 60) : QColor(90, 140, 210);
+            p.fillRect(r, color);
+            p.setPen(color.darker());
+            p.drawRect(r.adjusted(0, 0, -1, -1));
+            auto name = QFileInfo(s.target).fileName();
+            if (r.width() > p.fontMetrics().width(name) / 2) {
+                p.setPen(Qt::white);
+                p.drawText(r.adjusted(2, 0, -2, 0), Qt::AlignVCenter | Qt::AlignLeft,
+                           p.fontMetrics().elidedText(name, Qt::ElideRight, r.width() - 4));
+            }
+        }
+    }
+
+    bool event(QEvent *e) override {
+        if (e->type() == QEvent::ToolTip) {
+            auto he = static_cast<QHelpEvent*>(e);
+            auto s = stepAt(he->pos());
+            if (s)
+                QToolTip::showText(he->globalPos(),
+                                   tr("%1\n%2 ms, peak %3 MB, exit %4")
+                                   .arg(s->target)
+                                   .arg(s->duration())
+                                   .arg(s->peakRss < 0? QString("?") : QString::number(s->peakRss / 1024.0, 'f', 1))
+                                   .arg(s->exitCode), this);
+            else
+                QToolTip::hideText();
+            return true;
+        }
+        return QWidget::event(e);
+    }
+
+    void mouseDoubleClickEvent(QMouseEvent *e) override {
+        auto s = stepAt(e->pos());
+        if (s && s->kind == BuildStep::Kind::Compile)
+            emit view->fileActivated(s->target);
+    }
+
+private:
+    int xAt(qint64 t) const { return int((t - t0) * (width() - 1) / qMax<qint64>(1, t1 - t0)); }
+    qint64 timeAt(int x) const { return t0 + qint64(x) * qMax<qint64>(1, t1 - t0) / qMax(1, width() - 1); }
+
+    BuildTimelineView *view;
+    QVector<BuildStep> steps;
+    int lanes = 0;
+    qint64 t0 = 0;
+    qint64 t1 = 0;
+};
+
+BuildTimelineView::BuildTimelineView(QWidget *parent) :
+    QWidget(parent),
+    chart(new Chart(this)),
+    table(new QTreeWidget(this))
+{
+    auto scroll = new QScrollArea(this);
+    scroll->setWidget(chart);
+    scroll->setWidgetResizable(true);
+    table->setRootIsDecorated(false);
+    table->setSortingEnabled(true);
+    table->setHeaderLabels({ tr("File"), tr("Last (s)"), tr("Average (s)"), tr("Min (s)"), tr("Max (s)"),
+                             tr("Builds"), tr("Peak RSS (MB)") });
+    table->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+    connect(table, &QTreeWidget::itemActivated, [this](QTreeWidgetItem *item) {
+        emit fileActivated(item->data(0, Qt::UserRole).toString());
+    });
+    auto splitter = new QSplitter(Qt::Vertical, this);
+    splitter->addWidget(scroll);
+    splitter->addWidget(table);
+    auto layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addWidget(splitter);
+}
+
+BuildTimelineView::~BuildTimelineView()
+{
+}
+
+void BuildTimelineView::setSteps(const QVector<BuildStep> &steps, const QHash<QString, QVector<int>> &history)
+{
+    chart->setSteps(steps);
+    table->setSortingEnabled(false);
+    table->clear();
+    auto seconds = [](double ms) { return qRound(ms / 10.0) / 100.0; };
+    for (const auto& s: steps) {
+        if (s.kind != BuildStep::Kind::Compile)
+            continue;
+        auto times = history.value(s.target);
+        if (times.isEmpty())
+            times.append(int(s.duration()));
+        auto minmax = std::minmax_element(times.constBegin(), times.constEnd());
+        double sum = 0;
+        for (auto t: times)
+            sum += t;
+        auto item = new QTreeWidgetItem(table);
+        item->setText(0, QFileInfo(s.target).fileName());
+        item->setToolTip(0, s.target);
+        item->setData(0, Qt::UserRole, s.target);
+        item->setData(1, Qt::DisplayRole, seconds(s.duration()));
+        item->setData(2, Qt::DisplayRole, seconds(sum / times.size()));
+        item->setData(3, Qt::DisplayRole, seconds(*minmax.first));
+        item->setData(4, Qt::DisplayRole, seconds(*minmax.second));
+        item->setData(5, Qt::DisplayRole, times.size());
+        item->setData(6, Qt::DisplayRole, s.peakRss < 0? QVariant() : QVariant(qRound(s.peakRss / 102.4) / 10.0));
+    }
+    table->setSortingEnabled(true);
+    table->sortByColumn(1, Qt::DescendingOrder);
+}
+
+void BuildTimelineView::clear()
+{
+    setSteps({}, {});
+}
@@ -16,35 +16,33 @@
  * You should have received a copy of the GNU General Public License
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
-#ifndef REGEXHTMLTRANSLATOR_H
-#define REGEXHTMLTRANSLATOR_H
+#ifndef BUILDTIMELINEVIEW_H
+#define BUILDTIMELINEVIEW_H
 
-#include <QColor>
-#include <QList>
-#include <QRegularExpression>
+#include "buildtimeline.h"
 
-class QProcess;
+#include <QWidget>
 
-struct RegexEntry {
-    QRegularExpression re;
-    QLatin1String html;
-};
-
-using RegexList_t = QList<RegexEntry>;
+class QTreeWidget;
 
-class RegexHTMLTranslator
+class BuildTimelineView : public QWidget
 {
+    Q_OBJECT
 public:
+    explicit BuildTimelineView(QWidget *parent = nullptr);
+    ~BuildTimelineView() override;
 
-    RegexHTMLTranslator(const RegexList_t& reList) : regexs(reList) { }
-    RegexHTMLTranslator() : regexs(DEFAULT_REGEX) { }
+    void setSteps(const QVector<BuildStep>& steps, const QHash<QString, QVector<int>>& history);
+    void clear();
 
-    QString& operator()(QProcess *p, QString& s);
+signals:
+    void fileActivated(const QString& path);
 
-    static const RegexList_t DEFAULT_REGEX;
-    static RegexHTMLTranslator CONSOLE_TRANSLATOR;
 private:
-    RegexList_t regexs;
+    class Chart;
+
+    Chart *chart;
+    QTreeWidget *table;
 };
 
-#endif // REGEXHTMLTRANSLATOR_H
+#endif // BUILDTIMELINEVIEW_H
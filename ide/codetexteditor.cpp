@@ -18,6 +18,7 @@
  */
 #include "appconfig.h"
 #include "codetexteditor.h"
+#include "documentio.h"
 
 #include <QFileInfo>
 #include <QMenu>
@@ -79,11 +80,11 @@ CodeTextEditor::CodeTextEditor(QWidget *parent) : PlainTextEditor(parent)
 
 CodeTextEditor::~CodeTextEditor() {}
 
-bool CodeTextEditor::load(const QString &path)
+bool CodeTextEditor::attach(const DocumentBuffer &buffer)
 {
-    setLexer(lexerFromFile(path));
-    auto r = PlainTextEditor::load(path);
-    QFileInfo info(path);
+    setLexer(lexerFromFile(buffer.path));
+    auto r = PlainTextEditor::attach(buffer);
+    QFileInfo info(buffer.path);
     auto name = info.fileName();
     auto suffix = info.suffix();
     if (suffix == "mk" || MAKEFILES_NAME.contains(name)) {
@@ -93,6 +94,12 @@ bool CodeTextEditor::load(const QString &path)
     return r;
 }
 
+bool CodeTextEditor::attachView(IDocumentEditor *source)
+{
+    setLexer(lexerFromFile(source->path()));
+    return PlainTextEditor::attachView(source);
+}
+
 template<typename T> QsciLexer *helperCreator() { return new T(); }
 using creator_t = QsciLexer *(*)();
 
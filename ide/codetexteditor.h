@@ -28,7 +28,8 @@ public:
     explicit CodeTextEditor(QWidget *parent = nullptr);
     ~CodeTextEditor() override;
 
-    bool load(const QString &path) override;
+    bool attach(const DocumentBuffer &buffer) override;
+    bool attachView(IDocumentEditor *source) override;
 
     static IDocumentEditorCreator *creator();
 
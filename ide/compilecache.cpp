@@ -0,0 +1,92 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "compilecache.h"
+#include "appconfig.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QHash>
+
+#include <algorithm>
+
+static QString statsFileIn(const QString& cachePath)
+{
+    return QDir(cachePath).filePath("build.stats");
+}
+
+QString CompileCache::path()
+{
+    return AppConfig::ensureExist(QDir(AppConfig::instance().workspacePath()).filePath("compilecache"));
+}
+
+QString CompileCache::statsPath()
+{
+    return statsFileIn(path());
+}
+
+CompileCache::Report CompileCache::collect(const QString &cachePath, qint64 maxBytes)
+{
+    Report r;
+    // Moved aside before reading, a late append goes to a fresh file and is not lost
+    auto statsFile = statsFileIn(cachePath);
+    auto collected = statsFile + ".collect";
+    QFile::remove(collected);
+    QFile stats(collected);
+    if (QFile::rename(statsFile, collected) && stats.open(QFile::ReadOnly)) {
+        auto data = stats.readAll();
+        r.hits = data.count('H');
+        r.misses = data.count('M');
+        stats.close();
+        stats.remove();
+    }
+
+    // Entries are <key>.o plus optional .d and .err, the object time is the last use
+    struct Entry { QString base; QDateTime used; qint64 size = 0; };
+    QHash<QString, Entry> entries;
+    auto root = QDir(cachePath).absolutePath();
+    QDirIterator it(cachePath, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        auto info = it.fileInfo();
+        if (info.absolutePath() == root)
+            continue;
+        auto base = info.absolutePath() + '/' + info.completeBaseName();
+        auto& e = entries[base];
+        e.base = base;
+        e.size += info.size();
+        if (info.suffix() == "o")
+            e.used = info.lastModified();
+        r.size += info.size();
+    }
+    if (r.size <= maxBytes)
+        return r;
+    auto list = entries.values();
+    std::sort(list.begin(), list.end(), [](const Entry& a, const Entry& b) { return a.used < b.used; });
+    for (const auto& e: list) {
+        if (r.size <= maxBytes)
+            break;
+        for (const auto& suffix: { ".o", ".d", ".err" })
+            QFile::remove(e.base + suffix);
+        r.size -= e.size;
+        r.evicted++;
+    }
+    return r;
+}
@@ -0,0 +1,41 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef COMPILECACHE_H
+#define COMPILECACHE_H
+
+#include <QString>
+
+// The cache itself is filled by buildwrapper, the IDE counts and evicts
+class CompileCache
+{
+public:
+    struct Report {
+        int hits = 0;
+        int misses = 0;
+        int evicted = 0;
+        qint64 size = 0;
+    };
+
+    static QString path();
+    static QString statsPath();
+    // Runs off the GUI thread, the cache directory comes from path()
+    static Report collect(const QString& cachePath, qint64 maxBytes);
+};
+
+#endif // COMPILECACHE_H
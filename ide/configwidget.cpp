@@ -22,6 +22,7 @@
 #include "appconfig.h"
 #include "buttoneditoritemdelegate.h"
 #include "envinputdialog.h"
+#include "jobservergovernor.h"
 
 #include <QStringListModel>
 #include <QFileInfo>
@@ -210,10 +211,13 @@ void ConfigWidget::save()
     conf.setEditorShowSpaces(ui->editorShowSpaces->isChecked());
     conf.setEditorFormatterStyle(ui->formatterStyle->currentText());
     conf.setEditorDetectIdent(ui->editorDetectIdent->isChecked());
+    conf.setEditorLargeFileThreshold(ui->editorLargeFileThreshold->value());
+    conf.setEditorMaxLiveDocuments(ui->editorMaxLiveDocuments->value());
     conf.setTemplatesUrl(ui->templateSettings->repositoryUrl().toString());
     auto loggerFont = ui->loggerFontName->currentFont();
     loggerFont.setPointSize(ui->loggerFontSize->value());
     conf.setLoggerFont(loggerFont);
+    conf.setLoggerMaxLines(ui->loggerMaxLines->value());
     conf.setNetworkProxyHost(ui->proxyHost->text());
     conf.setNetworkProxyPort(ui->proxyPort->text());
     conf.setNetworkProxyUseCredentials(ui->useAutentication->isChecked());
@@ -234,6 +238,13 @@ void ConfigWidget::save()
     conf.setLanguage(ui->languageList->currentText());
     conf.setNumberOfJobs(ui->numberOfJobs->value());
     conf.setNumberOfJobsOptimal(ui->numberOfJobsOptimal->isChecked());
+    conf.setBuildInstrumentation(ui->buildInstrumentation->isChecked());
+    conf.setNumberOfJobsAdaptive(ui->numberOfJobsAdaptive->isChecked());
+    conf.setCompileCacheEnabled(ui->compileCacheEnabled->isChecked());
+    conf.setCompileCacheMaxSize(ui->compileCacheMaxSize->value());
+    conf.setFileCheckSyntaxOnly(ui->fileCheckSyntaxOnly->isChecked());
+    conf.setFileCheckLive(ui->fileCheckLive->isChecked());
+    conf.setFileCheckDelay(ui->fileCheckDelay->value());
     conf.save();
 }
 
@@ -252,6 +263,8 @@ void ConfigWidget::load()
     ui->editorReplaceTabs->setChecked(conf.editorTabsToSpaces());
     ui->editorTabWidth->setValue(conf.editorTabWidth());
     ui->editorDetectIdent->setChecked(conf.editorDetectIdent());
+    ui->editorLargeFileThreshold->setValue(conf.editorLargeFileThreshold());
+    ui->editorMaxLiveDocuments->setValue(conf.editorMaxLiveDocuments());
     ui->editorShowSpaces->setChecked(conf.editorShowSpaces());
     ui->formatterStyle->setCurrentText(conf.editorFormatterStyle());
     ui->formatterExtra->setText(conf.editorFormatterExtra());
@@ -259,6 +272,7 @@ void ConfigWidget::load()
     auto loggerFont = conf.loggerFont();
     ui->loggerFontName->setCurrentFont(loggerFont);
     ui->loggerFontSize->setValue(loggerFont.pointSize());
+    ui->loggerMaxLines->setValue(conf.loggerMaxLines());
     ui->proxyHost->setText(conf.networkProxyHost());
     ui->proxyPort->setText(conf.networkProxyPort());
     ui->useAutentication->setChecked(conf.networkProxyUseCredentials());
@@ -281,4 +295,12 @@ void ConfigWidget::load()
     ui->languageList->setCurrentText(conf.language());
     ui->numberOfJobs->setValue(conf.numberOfJobs());
     ui->numberOfJobsOptimal->setChecked(conf.numberOfJobsOptimal());
+    ui->buildInstrumentation->setChecked(conf.buildInstrumentation());
+    ui->numberOfJobsAdaptive->setChecked(conf.numberOfJobsAdaptive());
+    ui->numberOfJobsAdaptive->setEnabled(JobServerGovernor::isSupported());
+    ui->compileCacheEnabled->setChecked(conf.compileCacheEnabled());
+    ui->compileCacheMaxSize->setValue(conf.compileCacheMaxSize());
+    ui->fileCheckSyntaxOnly->setChecked(conf.fileCheckSyntaxOnly());
+    ui->fileCheckLive->setChecked(conf.fileCheckLive());
+    ui->fileCheckDelay->setValue(conf.fileCheckDelay());
 }
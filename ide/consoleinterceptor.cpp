@@ -18,42 +18,58 @@
  */
 #include "appconfig.h"
 #include "consoleinterceptor.h"
+#include "consoleview.h"
 #include "processmanager.h"
 
 #include <QTextCursor>
 #include <QTextBrowser>
 #include <QGridLayout>
 #include <QScrollBar>
+#include <QMenu>
 #include <QToolButton>
 #include <QEvent>
+#include <QTextBlock>
+#include <QTextDocument>
 
-ConsoleInterceptor::ConsoleInterceptor(QTextBrowser *textBrowser, QObject *parent) :
-    QObject(parent), browser(textBrowser)
+ConsoleInterceptor::ConsoleInterceptor(ConsoleView *consoleView, QObject *parent) :
+    QObject(parent), view(consoleView)
 {
     const auto size = QSize(16, 16);
-    auto gl = new QGridLayout(textBrowser);
-    m_clearButton = new QToolButton(textBrowser);
+    auto gl = new QGridLayout(consoleView);
+    m_clearButton = new QToolButton(consoleView);
     m_clearButton->setIcon(QIcon(AppConfig::resourceImage({ "actions", "edit-clear" })));
     m_clearButton->setAutoRaise(true);
     m_clearButton->setIconSize(size);
     m_clearButton->setToolTip(tr("Clear Console"));
 
-    m_killButton = new QToolButton(textBrowser);
+    m_historyButton = new QToolButton(consoleView);
+    m_historyButton->setIcon(QIcon(AppConfig::resourceImage({ "actions", "document-open" })));
+    m_historyButton->setAutoRaise(true);
+    m_historyButton->setIconSize(size);
+    m_historyButton->setToolTip(tr("Build History"));
+    m_historyButton->setPopupMode(QToolButton::InstantPopup);
+    m_historyButton->setMenu(new QMenu(m_historyButton));
+
+    m_killButton = new QToolButton(consoleView);
     m_killButton->setEnabled(false);
     m_killButton->setIcon(QIcon(AppConfig::resourceImage({ "actions", "window-close" })));
     m_killButton->setAutoRaise(true);
     m_killButton->setIconSize(size);
     m_killButton->setToolTip(tr("Stop Current Process"));
 
-    gl->addWidget(m_clearButton,  0, 1);
-    gl->addWidget(m_killButton, 0, 2);
+    gl->addWidget(m_historyButton, 0, 1);
+    gl->addWidget(m_clearButton,  0, 2);
+    gl->addWidget(m_killButton, 0, 3);
     gl->setColumnStretch(0, 1);
     gl->setRowStretch(1, 1);
-    gl->setContentsMargins(0, 0, textBrowser->verticalScrollBar()->sizeHint().width(), 0);
+    gl->setContentsMargins(0, 0, consoleView->verticalScrollBar()->sizeHint().width(), 0);
     gl->setSpacing(0);
-    textBrowser->setFont(QFont("Courier"));
-    connect(&AppConfig::instance(), &AppConfig::configChanged, [textBrowser](AppConfig *conf) {
-        textBrowser->setFont(conf->loggerFont());
+    consoleView->setFont(QFont("Courier"));
+    consoleView->setMaximumLineCount(AppConfig::instance().loggerMaxLines());
+    connect(m_clearButton, &QToolButton::clicked, consoleView, &ConsoleView::clear);
+    connect(&AppConfig::instance(), &AppConfig::configChanged, [consoleView](AppConfig *conf) {
+        consoleView->setFont(conf->loggerFont());
+        consoleView->setMaximumLineCount(conf->loggerMaxLines());
     });
 }
 
@@ -87,28 +103,57 @@ void ConsoleInterceptor::writeHtmlTo(QTextBrowser *browser, const QString &html)
     browser->verticalScrollBar()->setValue(browser->verticalScrollBar()->maximum());
 }
 
+void ConsoleInterceptor::writeMessageTo(ConsoleView *view, const QString &message, const QColor &color)
+{
+    QTextCharFormat fmt;
+    if (color.isValid())
+        fmt.setForeground(color);
+    writeMessageTo(view, message, fmt);
+}
+
+void ConsoleInterceptor::writeMessageTo(ConsoleView *view, const QString &message, const QTextCharFormat &fmt)
+{
+    view->appendText(message, fmt);
+}
+
 void ConsoleInterceptor::appendToConsole(QProcess::ProcessChannel s, QProcess *p, const QString &text)
 {
     Q_UNUSED(p)
     const auto& filters = s == QProcess::StandardError? stderrFilters : stdoutFilters;
     QString processedText{ text };
     for(const auto& c: filters)
-        if (c(browser, processedText))
+        if (c(view, processedText))
             return;
-    writeMessage(processedText, browser->palette().text().color());
+    auto& ansi = s == QProcess::StandardError? stderrAnsi : stdoutAnsi;
+    for (const auto& span: ansi.translate(processedText))
+        writeMessageTo(view, processedText.mid(span.start, span.length), span.format);
 }
 
 void ConsoleInterceptor::writeMessage(const QString &message, const QColor &color)
 {
-    writeMessageTo(browser, message, color);
+    writeMessageTo(view, message, color);
 }
 
 void ConsoleInterceptor::writeFmtMessage(const QString &message, const QTextCharFormat &fmt)
 {
-    writeMessageTo(browser, message, fmt);
+    writeMessageTo(view, message, fmt);
 }
 
 void ConsoleInterceptor::writeHtml(const QString &html)
 {
-    writeHtmlTo(browser, html);
+    // Each fragment keeps its format, so anchors and colors become console spans
+    QTextDocument doc;
+    doc.setHtml(html);
+    for(auto block = doc.begin(); block.isValid(); block = block.next()) {
+        if (block != doc.begin())
+            view->appendText("\n");
+        for(auto it = block.begin(); !it.atEnd(); ++it) {
+            auto fragment = it.fragment();
+            if (!fragment.isValid())
+                continue;
+            auto text = fragment.text();
+            text.replace(QChar::LineSeparator, '\n').replace(QChar::Nbsp, ' ');
+            view->appendText(text, fragment.charFormat());
+        }
+    }
 }
@@ -26,27 +26,33 @@
 #include <QToolButton>
 #include <QTextCharFormat>
 
+#include "ansitexttranslator.h"
+
 class QTextBrowser;
 class QProcess;
 
+class ConsoleView;
 class ProcessManager;
 
-using ConsoleInterceptorFilter = std::function<bool (QTextBrowser *b, QString& s)>;
+using ConsoleInterceptorFilter = std::function<bool (ConsoleView *v, QString& s)>;
 
 class ConsoleInterceptor : public QObject
 {
     Q_OBJECT
 public:
 
-    explicit ConsoleInterceptor(QTextBrowser *textBrowser, QObject *parent = nullptr);
+    explicit ConsoleInterceptor(ConsoleView *consoleView, QObject *parent = nullptr);
     virtual ~ConsoleInterceptor();
 
     QToolButton *killButton() { return m_killButton; }
     QToolButton *clearButton() { return m_clearButton; }
+    QToolButton *historyButton() { return m_historyButton; }
 
     static void writeMessageTo(QTextBrowser *browser, const QString& message, const QColor& color={});
     static void writeMessageTo(QTextBrowser *browser, const QString& message, const QTextCharFormat &fmt);
     static void writeHtmlTo(QTextBrowser *browser, const QString& html);
+    static void writeMessageTo(ConsoleView *view, const QString& message, const QColor& color={});
+    static void writeMessageTo(ConsoleView *view, const QString& message, const QTextCharFormat &fmt);
 
     void addStdOutFilter(const ConsoleInterceptorFilter& f) { stdoutFilters.append(f); }
     void addStdErrFilter(const ConsoleInterceptorFilter& f) { stderrFilters.append(f); }
@@ -62,9 +68,12 @@ public slots:
 private:
     QToolButton *m_killButton;
     QToolButton *m_clearButton;
-    QTextBrowser *browser;
+    QToolButton *m_historyButton;
+    ConsoleView *view;
     QList<ConsoleInterceptorFilter> stdoutFilters;
     QList<ConsoleInterceptorFilter> stderrFilters;
+    AnsiTextTranslator stdoutAnsi;
+    AnsiTextTranslator stderrAnsi;
 };
 
 #endif // CONSOLEINTERCEPTOR_H
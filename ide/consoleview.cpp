@@ -0,0 +1,435 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "consoleview.h"
+
+#include <QApplication>
+#include <QClipboard>
+#include <QContextMenuEvent>
+#include <QFontDatabase>
+#include <QFontInfo>
+#include <QKeyEvent>
+#include <QMenu>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QScrollBar>
+
+static constexpr int LINES_PER_CHUNK = 1024;
+static constexpr int FRAME_INTERVAL = 16;
+static constexpr int TAB_WIDTH = 8;
+static constexpr int TEXT_PADDING = 4;
+
+static QString colorKey(const QColor& c)
+{
+    return c.isValid()? c.name(QColor::HexArgb) : QString();
+}
+
+static int cellWidth(const QFontMetrics& fm)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 11, 0)
+    return qMax(1, fm.horizontalAdvance(QLatin1Char('0')));
+#else
+    return qMax(1, fm.width(QLatin1Char('0')));
+#endif
+}
+
+ConsoleView::ConsoleView(QWidget *parent) :
+    QAbstractScrollArea(parent)
+{
+    setFocusPolicy(Qt::StrongFocus);
+    viewport()->setMouseTracking(true);
+    viewport()->setCursor(Qt::IBeamCursor);
+    updateTimer.setSingleShot(true);
+    updateTimer.setInterval(FRAME_INTERVAL);
+    connect(&updateTimer, &QTimer::timeout, this, &ConsoleView::flushUpdate);
+    ensureFixedPitch();
+    clear();
+}
+
+ConsoleView::~ConsoleView()
+{
+}
+
+void ConsoleView::setMaximumLineCount(int lines)
+{
+    maxLines = lines;
+    dropOldLines();
+    scheduleUpdate();
+}
+
+int ConsoleView::lineCount() const
+{
+    // The last line is open for appends, an empty one is not shown
+    if (totalLines > 0 && chunks.last().last().text.isEmpty())
+        return totalLines - 1;
+    return totalLines;
+}
+
+QString ConsoleView::lineText(int line) const
+{
+    return line >= 0 && line < lineCount()? lineAt(line).text : QString();
+}
+
+QString ConsoleView::selectedText() const
+{
+    if (!hasSelection())
+        return QString();
+    auto from = qMin(selectionStart, selectionEnd);
+    auto to = qMax(selectionStart, selectionEnd);
+    QStringList parts;
+    for(auto abs = qMax(from.line, droppedLines); abs <= to.line; abs++) {
+        auto line = static_cast<int>(abs - droppedLines);
+        if (line >= lineCount())
+            break;
+        const auto& text = lineAt(line).text;
+        int c0 = abs == from.line? from.column : 0;
+        int c1 = abs == to.line? to.column : text.size();
+        parts.append(text.mid(c0, c1 - c0));
+    }
+    return parts.join('\n');
+}
+
+void ConsoleView::clear()
+{
+    chunks.clear();
+    totalLines = 0;
+    droppedLines = 0;
+    droppedSinceUpdate = 0;
+    longestLine = 0;
+    styles.clear();
+    styleIndex.clear();
+    styles.append(Style());
+    selectionStart = selectionEnd = Position();
+    selecting = false;
+    newLine();
+    updateTimer.stop();
+    updateScrollBars();
+    verticalScrollBar()->setValue(0);
+    viewport()->update();
+}
+
+void ConsoleView::appendText(const QString &text, const QTextCharFormat &fmt)
+{
+    if (text.isEmpty())
+        return;
+    int style = styleFor(fmt);
+    auto href = fmt.isAnchor()? fmt.anchorHref() : QString();
+    int from = 0;
+    forever {
+        int nl = text.indexOf('\n', from);
+        appendSegment(text.mid(from, nl < 0? -1 : nl - from), style, href);
+        if (nl < 0)
+            break;
+        newLine();
+        from = nl + 1;
+    }
+    dropOldLines();
+    scheduleUpdate();
+}
+
+void ConsoleView::copy()
+{
+    if (hasSelection())
+        QApplication::clipboard()->setText(selectedText());
+}
+
+void ConsoleView::selectAll()
+{
+    int count = lineCount();
+    if (count == 0)
+        return;
+    selectionStart = { droppedLines, 0 };
+    selectionEnd = { droppedLines + count - 1, lineAt(count - 1).text.size() };
+    viewport()->update();
+}
+
+void ConsoleView::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+    QPainter p(viewport());
+    const auto& pal = palette();
+    const auto fm = fontMetrics();
+    const int lh = fm.height();
+    const int cw = cellWidth(fm);
+    const int firstColumn = horizontalScrollBar()->value();
+    const int lastColumn = firstColumn + viewport()->width() / cw + 1;
+    const int xoff = TEXT_PADDING - firstColumn * cw;
+    const int first = verticalScrollBar()->value();
+    const int rows = viewport()->height() / lh + 1;
+    const auto selFrom = qMin(selectionStart, selectionEnd);
+    const auto selTo = qMax(selectionStart, selectionEnd);
+    auto normalFont = font();
+    auto boldFont = font();
+    boldFont.setBold(true);
+    auto linkFont = font();
+    linkFont.setUnderline(true);
+
+    p.fillRect(viewport()->rect(), pal.base());
+    for(int r = 0; r < rows; r++) {
+        int line = first + r;
+        if (line >= lineCount())
+            break;
+        int y = r * lh;
+        const auto& l = lineAt(line);
+        auto abs = droppedLines + line;
+        if (hasSelection() && abs >= selFrom.line && abs <= selTo.line) {
+            int c0 = abs == selFrom.line? selFrom.column : 0;
+            int c1 = abs == selTo.line? selTo.column : l.text.size() + 1;
+            p.fillRect(QRect(xoff + c0 * cw, y, (c1 - c0) * cw, lh), pal.highlight());
+        }
+        // Only the columns inside the viewport are drawn
+        auto drawRun = [&](int start, int length, const Style *st) {
+            int a = qMax(start, firstColumn);
+            int b = qMin(start + length, lastColumn);
+            if (a >= b)
+                return;
+            QRect rect(xoff + a * cw, y, (b - a) * cw, lh);
+            if (st && st->background.isValid())
+                p.fillRect(rect, st->background);
+            QColor color = pal.text().color();
+            if (st && st->foreground.isValid())
+                color = st->foreground;
+            else if (st && st->link)
+                color = pal.link().color();
+            p.setPen(color);
+            p.setFont(st && st->link? linkFont : (st && st->bold? boldFont : normalFont));
+            p.drawText(rect.x(), y + fm.ascent(), l.text.mid(a, b - a));
+        };
+        int col = 0;
+        for(const auto& span: l.spans) {
+            if (span.start > col)
+                drawRun(col, span.start - col, nullptr);
+            drawRun(span.start, span.length, &styles.at(span.style));
+            col = span.start + span.length;
+        }
+        if (col < l.text.size())
+            drawRun(col, l.text.size() - col, nullptr);
+    }
+}
+
+void ConsoleView::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+}
+
+void ConsoleView::changeEvent(QEvent *event)
+{
+    QAbstractScrollArea::changeEvent(event);
+    if (event->type() == QEvent::FontChange) {
+        ensureFixedPitch();
+        updateScrollBars();
+        viewport()->update();
+    }
+}
+
+void ConsoleView::keyPressEvent(QKeyEvent *event)
+{
+    if (event->matches(QKeySequence::Copy))
+        copy();
+    else if (event->matches(QKeySequence::SelectAll))
+        selectAll();
+    else
+        QAbstractScrollArea::keyPressEvent(event);
+}
+
+void ConsoleView::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton)
+        return;
+    selectionStart = selectionEnd = positionAt(event->pos());
+    selecting = true;
+    pressedHref = hrefAt(event->pos());
+    viewport()->update();
+}
+
+void ConsoleView::mouseMoveEvent(QMouseEvent *event)
+{
+    viewport()->setCursor(hrefAt(event->pos()).isEmpty()? Qt::IBeamCursor : Qt::PointingHandCursor);
+    if (selecting) {
+        selectionEnd = positionAt(event->pos());
+        viewport()->update();
+    }
+}
+
+void ConsoleView::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton)
+        return;
+    selecting = false;
+    if (!hasSelection() && !pressedHref.isEmpty() && pressedHref == hrefAt(event->pos()))
+        emit anchorClicked(QUrl(pressedHref));
+    pressedHref.clear();
+}
+
+void ConsoleView::contextMenuEvent(QContextMenuEvent *event)
+{
+    QMenu menu(this);
+    menu.addAction(tr("Copy"), this, &ConsoleView::copy)->setEnabled(hasSelection());
+    menu.addAction(tr("Select All"), this, &ConsoleView::selectAll);
+    menu.exec(event->globalPos());
+}
+
+void ConsoleView::ensureFixedPitch()
+{
+    // Lines are laid out in cells, a proportional font does not fit them
+    if (QFontInfo(font()).fixedPitch())
+        return;
+    auto fixed = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+    if (font().pointSizeF() > 0)
+        fixed.setPointSizeF(font().pointSizeF());
+    if (fixed != font())
+        setFont(fixed);
+}
+
+const ConsoleView::Line &ConsoleView::lineAt(int line) const
+{
+    return chunks.at(line / LINES_PER_CHUNK).at(line % LINES_PER_CHUNK);
+}
+
+void ConsoleView::newLine()
+{
+    if (chunks.isEmpty() || chunks.last().size() >= LINES_PER_CHUNK) {
+        chunks.append(QVector<Line>());
+        chunks.last().reserve(LINES_PER_CHUNK);
+    }
+    chunks.last().append(Line());
+    totalLines++;
+}
+
+void ConsoleView::appendSegment(const QString &segment, int style, const QString &href)
+{
+    auto& l = lastLine();
+    QString s;
+    if (segment.contains('\t') || segment.contains('\r')) {
+        s.reserve(segment.size());
+        for(const auto& c: segment) {
+            if (c == '\r')
+                continue;
+            if (c == '\t')
+                s.append(QString(TAB_WIDTH - (l.text.size() + s.size()) % TAB_WIDTH, ' '));
+            else
+                s.append(c);
+        }
+    } else
+        s = segment;
+    if (s.isEmpty())
+        return;
+    if (style != 0) {
+        if (!l.spans.isEmpty() && l.spans.last().style == style && l.spans.last().href == href &&
+                l.spans.last().start + l.spans.last().length == l.text.size())
+            l.spans.last().length += s.size();
+        else
+            l.spans.append(Span{ l.text.size(), s.size(), style, href });
+    }
+    l.text.append(s);
+    longestLine = qMax(longestLine, l.text.size());
+}
+
+int ConsoleView::styleFor(const QTextCharFormat &fmt)
+{
+    Style s;
+    if (fmt.hasProperty(QTextFormat::ForegroundBrush))
+        s.foreground = fmt.foreground().color();
+    if (fmt.hasProperty(QTextFormat::BackgroundBrush))
+        s.background = fmt.background().color();
+    s.bold = fmt.hasProperty(QTextFormat::FontWeight) && fmt.fontWeight() >= QFont::Bold;
+    s.link = fmt.isAnchor();
+    if (!s.foreground.isValid() && !s.background.isValid() && !s.bold && !s.link)
+        return 0;
+    auto key = QString("%1|%2|%3|%4")
+            .arg(colorKey(s.foreground), colorKey(s.background))
+            .arg(s.bold)
+            .arg(s.link);
+    auto it = styleIndex.constFind(key);
+    if (it != styleIndex.constEnd())
+        return it.value();
+    styles.append(s);
+    styleIndex.insert(key, styles.size() - 1);
+    return styles.size() - 1;
+}
+
+void ConsoleView::dropOldLines()
+{
+    if (maxLines <= 0)
+        return;
+    while (chunks.size() > 1 && totalLines - chunks.first().size() >= maxLines) {
+        int n = chunks.first().size();
+        chunks.removeFirst();
+        totalLines -= n;
+        droppedLines += n;
+        droppedSinceUpdate += n;
+    }
+}
+
+void ConsoleView::scheduleUpdate()
+{
+    // Appends are coalesced, at most one layout and repaint per frame
+    if (!updateTimer.isActive())
+        updateTimer.start();
+}
+
+void ConsoleView::flushUpdate()
+{
+    auto bar = verticalScrollBar();
+    bool follow = bar->value() >= bar->maximum();
+    int value = qMax(0, bar->value() - droppedSinceUpdate);
+    droppedSinceUpdate = 0;
+    updateScrollBars();
+    bar->setValue(follow? bar->maximum() : value);
+    viewport()->update();
+}
+
+void ConsoleView::updateScrollBars()
+{
+    const auto fm = fontMetrics();
+    const int rows = qMax(1, viewport()->height() / fm.height());
+    const int cols = viewport()->width() / cellWidth(fm);
+    verticalScrollBar()->setRange(0, qMax(0, lineCount() - rows));
+    verticalScrollBar()->setPageStep(rows);
+    horizontalScrollBar()->setRange(0, qMax(0, longestLine - cols + 1));
+    horizontalScrollBar()->setPageStep(cols);
+}
+
+ConsoleView::Position ConsoleView::positionAt(const QPoint &p) const
+{
+    const auto fm = fontMetrics();
+    const int cw = cellWidth(fm);
+    int count = lineCount();
+    if (count == 0)
+        return { droppedLines, 0 };
+    int line = qBound(0, verticalScrollBar()->value() + p.y() / fm.height(), count - 1);
+    int x = p.x() - TEXT_PADDING + horizontalScrollBar()->value() * cw;
+    int column = qBound(0, (x + cw / 2) / cw, lineAt(line).text.size());
+    return { droppedLines + line, column };
+}
+
+QString ConsoleView::hrefAt(const QPoint &p) const
+{
+    const auto fm = fontMetrics();
+    const int cw = cellWidth(fm);
+    int line = verticalScrollBar()->value() + p.y() / fm.height();
+    int x = p.x() - TEXT_PADDING + horizontalScrollBar()->value() * cw;
+    if (line >= lineCount() || x < 0)
+        return QString();
+    int column = x / cw;
+    for(const auto& span: lineAt(line).spans)
+        if (column >= span.start && column < span.start + span.length)
+            return span.href;
+    return QString();
+}
@@ -0,0 +1,116 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef CONSOLEVIEW_H
+#define CONSOLEVIEW_H
+
+#include <QAbstractScrollArea>
+#include <QHash>
+#include <QTextCharFormat>
+#include <QTimer>
+#include <QUrl>
+#include <QVector>
+
+class ConsoleView : public QAbstractScrollArea
+{
+    Q_OBJECT
+public:
+    explicit ConsoleView(QWidget *parent = nullptr);
+    ~ConsoleView() override;
+
+    int maximumLineCount() const { return maxLines; }
+    void setMaximumLineCount(int lines);
+    int lineCount() const;
+    QString lineText(int line) const;
+    bool hasSelection() const { return selectionStart != selectionEnd; }
+    QString selectedText() const;
+
+signals:
+    void anchorClicked(const QUrl& url);
+
+public slots:
+    void clear();
+    void appendText(const QString& text, const QTextCharFormat& fmt = QTextCharFormat());
+    void copy();
+    void selectAll();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void changeEvent(QEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void contextMenuEvent(QContextMenuEvent *event) override;
+
+private:
+    struct Style {
+        QColor foreground;
+        QColor background;
+        bool bold = false;
+        bool link = false;
+    };
+    struct Span {
+        int start;
+        int length;
+        int style;
+        QString href; // Kept out of the styles, every diagnostic has its own
+    };
+    struct Line {
+        QString text;
+        QVector<Span> spans;
+    };
+    struct Position {
+        qint64 line = 0; // Counted from the first line ever appended
+        int column = 0;
+        bool operator<(const Position& o) const { return line < o.line || (line == o.line && column < o.column); }
+        bool operator!=(const Position& o) const { return line != o.line || column != o.column; }
+    };
+
+    void ensureFixedPitch();
+    const Line& lineAt(int line) const;
+    Line& lastLine() { return chunks.last().last(); }
+    void newLine();
+    void appendSegment(const QString& segment, int style, const QString& href);
+    int styleFor(const QTextCharFormat& fmt);
+    void dropOldLines();
+    void scheduleUpdate();
+    void flushUpdate();
+    void updateScrollBars();
+    Position positionAt(const QPoint& p) const;
+    QString hrefAt(const QPoint& p) const;
+
+    QVector<QVector<Line>> chunks; // Oldest lines are dropped a whole chunk at a time
+    int totalLines = 0;
+    qint64 droppedLines = 0;
+    int droppedSinceUpdate = 0;
+    int longestLine = 0;
+    int maxLines = 0;
+
+    QVector<Style> styles;
+    QHash<QString, int> styleIndex;
+
+    QTimer updateTimer;
+    Position selectionStart;
+    Position selectionEnd;
+    bool selecting = false;
+    QString pressedHref;
+};
+
+#endif // CONSOLEVIEW_H
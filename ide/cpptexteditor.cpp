@@ -18,8 +18,11 @@
  */
 #include "appconfig.h"
 #include "cpptexteditor.h"
+#include "documentio.h"
 #include "filereferencesdialog.h"
 #include "icodemodelprovider.h"
+#include "linediff.h"
+#include "sourceformatter.h"
 #include "textmessagebrocker.h"
 
 #include <Qsci/qscilexercpp.h>
@@ -27,13 +30,13 @@
 
 #include <QMenu>
 
+#include <QFutureWatcher>
 #include <QMimeDatabase>
 #include <QRegularExpression>
 #include <QShortcut>
-#include <astyle.h>
+#include <QtConcurrent>
 
 #include <QtDebug>
-#include <astyle_main.h>
 
 static const QStringList C_CXX_EXTENSIONS = { "c", "cpp", "h", "hpp", "cc", "hh", "hxx", "cxx", "c++", "h++" };
 static const QStringList C_MIMETYPE = { "text/x-c++src", "text/x-c++hdr" };
@@ -41,7 +44,7 @@ static const QStringList CXX_MIMETYPE = { "text/x-c", "text/x-csrc", "text/x-chd
 
 static inline void triggerFindAndOpen(const QString& filePath)
 {
-    TextMessageBrocker::instance().publish("findAndOpen", filePath);
+    TextMessageBrocker::instance().publish(TextMessages::FIND_AND_OPEN, filePath);
 }
 
 class MyQsciLexerCPP: public QsciLexerCPP {
@@ -91,11 +94,11 @@ CPPTextEditor::CPPTextEditor(QWidget *parent) : CodeTextEditor(parent)
 
 CPPTextEditor::~CPPTextEditor() = default;
 
-bool CPPTextEditor::load(const QString &path)
+bool CPPTextEditor::attach(const DocumentBuffer &buffer)
 {
-    if (codeModel())
-        codeModel()->startIndexingFile(path, [] {});
-    return CodeTextEditor::load(path);
+    if (codeModel() && buffer.valid)
+        codeModel()->startIndexingFile(buffer.path, [] {});
+    return CodeTextEditor::attach(buffer);
 }
 
 class CPPEditorCreator: public IDocumentEditorCreator
@@ -130,6 +133,11 @@ public:
     }
 };
 
+const QStringList &CPPTextEditor::sourceExtensions()
+{
+    return C_CXX_EXTENSIONS;
+}
+
 IDocumentEditorCreator *CPPTextEditor::creator()
 {
     return IDocumentEditorCreator::staticCreator<CPPEditorCreator>();
@@ -153,43 +161,54 @@ void CPPTextEditor::findReference()
         qDebug() << "No code model defined";
 }
 
-static STDCALL char* tempMemoryAllocation(unsigned long memoryNeeded)
-{
-    char* buffer = new char[memoryNeeded];
-    return buffer;
-}
-
-static STDCALL void tempError(int errorNumber, const char* errorMessage)
-{
-    qDebug() << errorNumber << errorMessage;
-    TextMessageBrocker::instance().publish(TextMessages::STDERR_LOG, QString("%1: %2").arg(errorNumber).arg(errorMessage));
+namespace {
+struct FormatJob {
+    SourceFormatter::Result result;
+    QVector<TextEdit> edits;
+};
 }
 
 void CPPTextEditor::formatCode()
 {
-    int l;
-    int i;
-    getCursorPosition(&l, &i);
-    auto inText = selectedText();
-    if (inText.isEmpty()) {
-        selectAll();
-        inText = selectedText();
+    int start = 0;
+    int end = static_cast<int>(SendScintilla(SCI_GETLENGTH));
+    if (hasSelectedText()) {
+        // Format whole lines of the selection
+        int lineFrom;
+        int indexFrom;
+        int lineTo;
+        int indexTo;
+        getSelection(&lineFrom, &indexFrom, &lineTo, &indexTo);
+        if (indexTo == 0 && lineTo > lineFrom)
+            lineTo--;
+        start = positionFromLineIndex(lineFrom, 0);
+        if (lineTo + 1 < lines())
+            end = positionFromLineIndex(lineTo + 1, 0);
     }
-    auto rawText = inText.toUtf8();
-    char* utf8In = rawText.data();
-    auto& cfg = AppConfig::instance();
-    const auto style = cfg.editorFormatterStyle();
-    const auto indentType = QString{cfg.editorTabsToSpaces()? "spaces" : "tab"};
-    const auto indentCount = QString("%1").arg(cfg.editorTabWidth());
-    auto extraAstyleParams = cfg.editorFormatterExtra();
-    char* utf8Out = AStyleMain(utf8In,
-                               QString("--style=%1 --indent=%2=%3 %4")
-                                   .arg(style, indentType, indentCount, extraAstyleParams).toLatin1().data(),
-                               tempError,
-                               tempMemoryAllocation);
-    replaceSelectedText(QString::fromUtf8(utf8Out));
-    setCursorPosition(l, i);
-    ensureLineVisible(l);
+    auto before = textRange(start, end);
+    auto formatter = SourceFormatter::fromConfig();
+    auto watcher = new QFutureWatcher<FormatJob>(this);
+    connect(watcher, &QFutureWatcher<FormatJob>::finished, this, [this, watcher, start, before]() {
+        watcher->deleteLater();
+        auto job = watcher->result();
+        for(const auto& e: job.result.errors)
+            TextMessageBrocker::instance().publish(TextMessages::STDERR_LOG, e);
+        if (!job.result.valid)
+            return;
+        if (textRange(start, start + before.size()) != before) {
+            TextMessageBrocker::instance().publish(TextMessages::STDERR_LOG,
+                                                   tr("Document changed while formatting, result discarded"));
+            return;
+        }
+        applyTextEdits(start, job.edits);
+    });
+    watcher->setFuture(QtConcurrent::run([formatter, before]() {
+        FormatJob job;
+        job.result = formatter.format(before);
+        if (job.result.valid)
+            job.edits = LineDiff::edits(before, job.result.text);
+        return job;
+    }));
 }
 
 void CPPTextEditor::openIncludeInCursor()
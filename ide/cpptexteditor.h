@@ -29,9 +29,10 @@ public:
     explicit CPPTextEditor(QWidget *parent = nullptr);
     virtual ~CPPTextEditor() override;
 
-    bool load(const QString &path) override;
+    bool attach(const DocumentBuffer &buffer) override;
 
     static IDocumentEditorCreator *creator();
+    static const QStringList& sourceExtensions();
 
 signals:
     void queryToOpen(const QString& path);
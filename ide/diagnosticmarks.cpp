@@ -0,0 +1,113 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "diagnosticmarks.h"
+
+#include <Qsci/qsciscintilla.h>
+
+static constexpr int ERROR_INDICATOR = 1; // 0 belongs to the occurrence highlighter
+static constexpr int WARNING_INDICATOR = 2;
+static constexpr int ERROR_MARKER = 10;
+static constexpr int WARNING_MARKER = 11;
+static constexpr int DWELL_MS = 500;
+static constexpr auto ERROR_COLOR = 0x0000ee; // Scintilla colors are BGR
+static constexpr auto WARNING_COLOR = 0x00a0e0;
+
+DiagnosticMarks::DiagnosticMarks(QsciScintilla *editor) :
+    QObject(editor),
+    editor(editor)
+{
+    setObjectName("diagnosticMarks");
+    editor->SendScintilla(QsciScintilla::SCI_INDICSETSTYLE, ERROR_INDICATOR, QsciScintilla::INDIC_SQUIGGLE);
+    editor->SendScintilla(QsciScintilla::SCI_INDICSETFORE, ERROR_INDICATOR, ERROR_COLOR);
+    editor->SendScintilla(QsciScintilla::SCI_INDICSETSTYLE, WARNING_INDICATOR, QsciScintilla::INDIC_SQUIGGLE);
+    editor->SendScintilla(QsciScintilla::SCI_INDICSETFORE, WARNING_INDICATOR, WARNING_COLOR);
+    editor->markerDefine(QsciScintilla::Circle, ERROR_MARKER);
+    editor->setMarkerBackgroundColor(Qt::red, ERROR_MARKER);
+    editor->markerDefine(QsciScintilla::Circle, WARNING_MARKER);
+    editor->setMarkerBackgroundColor(QColor(0xe0, 0xa0, 0x00), WARNING_MARKER);
+    editor->SendScintilla(QsciScintilla::SCI_SETMOUSEDWELLTIME, DWELL_MS);
+    connect(editor, &QsciScintilla::SCN_DWELLSTART, this, [this](int position) { showMessage(position); });
+    connect(editor, &QsciScintilla::SCN_DWELLEND, this, &DiagnosticMarks::hideMessage);
+}
+
+DiagnosticMarks::~DiagnosticMarks() = default;
+
+DiagnosticMarks *DiagnosticMarks::of(QsciScintilla *editor)
+{
+    auto marks = editor->findChild<DiagnosticMarks*>("diagnosticMarks", Qt::FindDirectChildrenOnly);
+    return marks? marks : new DiagnosticMarks(editor);
+}
+
+void DiagnosticMarks::setDiagnostics(const QVector<BuildDiagnostic> &list)
+{
+    clear();
+    auto lines = editor->lines();
+    for (const auto& d: list) {
+        if (d.severity == BuildDiagnostic::Severity::Note || d.line < 1 || d.line > lines)
+            continue;
+        bool error = d.severity == BuildDiagnostic::Severity::Error;
+        int line = d.line - 1;
+        long start = editor->SendScintilla(QsciScintilla::SCI_POSITIONFROMLINE, line);
+        long end = editor->SendScintilla(QsciScintilla::SCI_GETLINEENDPOSITION, line);
+        if (d.column > 0) {
+            // Compiler columns count like the display, with tabs expanded
+            start = editor->SendScintilla(QsciScintilla::SCI_FINDCOLUMN, line, d.column - 1);
+            auto wordEnd = editor->SendScintilla(QsciScintilla::SCI_WORDENDPOSITION, static_cast<unsigned long>(start), true);
+            end = wordEnd > start? wordEnd : qMin(start + 1, end);
+        }
+        if (end > start) {
+            editor->SendScintilla(QsciScintilla::SCI_SETINDICATORCURRENT, error? ERROR_INDICATOR : WARNING_INDICATOR);
+            editor->SendScintilla(QsciScintilla::SCI_INDICATORFILLRANGE, static_cast<unsigned long>(start), end - start);
+        }
+        auto handle = editor->markerAdd(line, error? ERROR_MARKER : WARNING_MARKER);
+        if (handle >= 0)
+            messages.insert(handle, d.message);
+    }
+}
+
+void DiagnosticMarks::clear()
+{
+    auto length = editor->SendScintilla(QsciScintilla::SCI_GETLENGTH);
+    for (auto indicator: { ERROR_INDICATOR, WARNING_INDICATOR }) {
+        editor->SendScintilla(QsciScintilla::SCI_SETINDICATORCURRENT, indicator);
+        editor->SendScintilla(QsciScintilla::SCI_INDICATORCLEARRANGE, 0, length);
+    }
+    editor->markerDeleteAll(ERROR_MARKER);
+    editor->markerDeleteAll(WARNING_MARKER);
+    messages.clear();
+}
+
+void DiagnosticMarks::showMessage(int position)
+{
+    if (position < 0 || messages.isEmpty())
+        return;
+    auto line = static_cast<int>(editor->SendScintilla(QsciScintilla::SCI_LINEFROMPOSITION, position));
+    QStringList text;
+    for (auto it = messages.cbegin(); it != messages.cend(); ++it)
+        if (editor->markerLine(it.key()) == line)
+            text.append(it.value());
+    if (!text.isEmpty())
+        editor->SendScintilla(QsciScintilla::SCI_CALLTIPSHOW, static_cast<unsigned long>(position),
+                              text.join('\n').toUtf8().constData());
+}
+
+void DiagnosticMarks::hideMessage()
+{
+    editor->SendScintilla(QsciScintilla::SCI_CALLTIPCANCEL);
+}
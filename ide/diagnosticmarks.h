@@ -0,0 +1,53 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef DIAGNOSTICMARKS_H
+#define DIAGNOSTICMARKS_H
+
+#include "buildoutputparser.h"
+
+#include <QHash>
+#include <QObject>
+
+class QsciScintilla;
+
+// Squiggles under the diagnostics of a document and markers in its symbol
+// margin, the message shows as a calltip while the mouse rests on the line
+class DiagnosticMarks : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DiagnosticMarks(QsciScintilla *editor);
+    ~DiagnosticMarks() override;
+
+    static DiagnosticMarks *of(QsciScintilla *editor);
+
+public slots:
+    void setDiagnostics(const QVector<BuildDiagnostic>& list);
+    void clear();
+
+private slots:
+    void showMessage(int position);
+    void hideMessage();
+
+private:
+    QsciScintilla *editor;
+    QHash<int, QString> messages; // By marker handle, handles follow the edits
+};
+
+#endif // DIAGNOSTICMARKS_H
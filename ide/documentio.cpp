@@ -0,0 +1,137 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "documentio.h"
+#include "appconfig.h"
+
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QSaveFile>
+#include <QTextCodec>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <memory>
+
+static constexpr int UTF8_MIB = 106;
+
+namespace {
+
+struct PathWriteState {
+    QMutex mutex;
+    quint64 generation = 0;  // Guarded by writeRegistryMutex
+    QFuture<QString> latest; // The write of the last generation, same guard
+};
+
+QMutex writeRegistryMutex;
+QHash<QString, std::shared_ptr<PathWriteState>> writeRegistry;
+
+}
+
+DocumentBuffer DocumentIO::read(const QString &path, int tabWidth)
+{
+    DocumentBuffer buffer;
+    buffer.path = path;
+    QFile f(path);
+    if (!f.open(QFile::ReadOnly)) {
+        buffer.errorString = f.errorString();
+        return buffer;
+    }
+    buffer.bytes = f.readAll();
+    if (f.error() != QFile::NoError) {
+        buffer.errorString = f.errorString();
+        buffer.bytes.clear();
+        return buffer;
+    }
+    // Editors work in UTF-8, convert only when a BOM says otherwise
+    auto codec = QTextCodec::codecForUtfText(buffer.bytes, nullptr);
+    if (codec && codec->mibEnum() != UTF8_MIB)
+        buffer.bytes = codec->toUnicode(buffer.bytes).toUtf8();
+    buffer.indent = IndentDetector::detect(buffer.bytes, tabWidth);
+    buffer.valid = true;
+    return buffer;
+}
+
+QFuture<DocumentBuffer> DocumentIO::readAsync(const QString &path)
+{
+    return QtConcurrent::run(pool(), &DocumentIO::read, path, AppConfig::instance().editorTabWidth());
+}
+
+QString DocumentIO::write(const DocumentBuffer &buffer)
+{
+    // Temp file + rename, the target is never left truncated
+    QSaveFile f(buffer.path);
+    if (!f.open(QFile::WriteOnly))
+        return f.errorString();
+    if (f.write(buffer.bytes) != buffer.bytes.size()) {
+        auto error = f.errorString();
+        f.cancelWriting();
+        return error;
+    }
+    if (!f.commit())
+        return f.errorString();
+    return QString();
+}
+
+QFuture<QString> DocumentIO::writeAsync(const DocumentBuffer &buffer)
+{
+    QMutexLocker locker(&writeRegistryMutex);
+    auto& entry = writeRegistry[buffer.path];
+    if (!entry)
+        entry = std::make_shared<PathWriteState>();
+    auto state = entry;
+    auto generation = ++state->generation;
+    // Writes of one path are serialized. A snapshot superseded by a newer one is not
+    // written, it finishes with the newer write and reports its result.
+    state->latest = QtConcurrent::run(pool(), [buffer, state, generation]() {
+        QFuture<QString> newer;
+        {
+            QMutexLocker pathLocker(&state->mutex);
+            bool superseded;
+            {
+                QMutexLocker locker(&writeRegistryMutex);
+                superseded = state->generation != generation;
+                if (superseded)
+                    newer = state->latest;
+            }
+            if (!superseded)
+                return write(buffer);
+        }
+        newer.waitForFinished();
+        return newer.result();
+    });
+    return state->latest;
+}
+
+void DocumentIO::waitForWrites()
+{
+    pool()->waitForDone();
+}
+
+QThreadPool *DocumentIO::pool()
+{
+    static QThreadPool *staticPool = nullptr;
+    if (!staticPool) {
+        staticPool = new QThreadPool();
+        // I/O bound: a few readers keep several opens in flight without starving the CPU pool
+        staticPool->setMaxThreadCount(qMax(2, QThread::idealThreadCount() / 2));
+    }
+    return staticPool;
+}
@@ -0,0 +1,53 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef DOCUMENTIO_H
+#define DOCUMENTIO_H
+
+#include "indentdetector.h"
+
+#include <QByteArray>
+#include <QFuture>
+#include <QString>
+
+class QThreadPool;
+
+struct DocumentBuffer
+{
+    QString path;
+    QByteArray bytes; // UTF-8 text, ready for the editor
+    IndentInfo indent;
+    bool valid = false;
+    QString errorString;
+};
+
+class DocumentIO
+{
+public:
+    // The tab width of the configuration is taken by the caller, workers cannot read it
+    static DocumentBuffer read(const QString& path, int tabWidth);
+    static QFuture<DocumentBuffer> readAsync(const QString& path);
+    // Write results are an empty string on success or the error description
+    static QString write(const DocumentBuffer& buffer);
+    static QFuture<QString> writeAsync(const DocumentBuffer& buffer);
+    static void waitForWrites();
+
+    static QThreadPool *pool();
+};
+
+#endif // DOCUMENTIO_H
@@ -28,18 +28,33 @@
 #include "unsavedfilesdialog.h"
 #include "textmessagebrocker.h"
 #include "imageviewer.h"
+#include "largefileviewer.h"
 #include "markdowneditor.h"
 #include "appconfig.h"
+#include "documentio.h"
 
 #include <QApplication>
 #include <QComboBox>
+#include <QDateTime>
 #include <QDir>
+#include <QEventLoop>
 #include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QFutureWatcher>
+#include <QJsonArray>
+#include <QJsonObject>
 #include <QLabel>
+#include <QMessageBox>
 #include <QMimeDatabase>
+#include <QPointer>
+#include <QSet>
 #include <QShortcut>
+#include <QSignalBlocker>
 #include <QSortFilterProxyModel>
+#include <QSplitter>
 #include <QStackedLayout>
+#include <QTimer>
+#include <QVBoxLayout>
 
 #include <QtDebug>
 
@@ -47,11 +62,54 @@ static QString absoluteTo(const QString& path, const QString& file) {
     return QFileInfo(file).isAbsolute()? file : QDir(path).absoluteFilePath(file);
 }
 
+struct PendingDocument {
+    IDocumentEditor *editor = nullptr;
+    QWidget *placeholder = nullptr;
+    QPoint cursor;
+    bool hasCursor = false;
+    QVariantMap state;
+};
+
+struct DeferredDocument {
+    QWidget *placeholder = nullptr;
+    QVariantMap state;
+};
+
+struct DiskStamp {
+    QDateTime modified;
+    qint64 size = -1;
+
+    static DiskStamp of(const QString& path) {
+        QFileInfo info(path);
+        DiskStamp s;
+        if (info.exists()) {
+            s.modified = info.lastModified();
+            s.size = info.size();
+        }
+        return s;
+    }
+    bool isValid() const { return size >= 0; }
+    bool operator==(const DiskStamp& o) const { return modified == o.modified && size == o.size; }
+};
+
+static constexpr int EXTERNAL_CHANGE_DEBOUNCE = 200;
+
 class DocumentManager::Priv_t {
 public:
     QComboBox *combo = nullptr;
     QStackedLayout *stack = nullptr;
+    QSplitter *splitter = nullptr;
+    IDocumentEditor *splitView = nullptr;
+    QString splitPath;
     QHash<QString, IDocumentEditor*> mapedWidgets;
+    QHash<QString, PendingDocument> pendingDocuments;
+    QHash<QString, DeferredDocument> deferredDocuments;
+    QStringList recentlyUsed;
+    QFileSystemWatcher *fileWatcher = nullptr;
+    QTimer *changeTimer = nullptr;
+    QSet<QString> changedPaths;
+    QHash<QString, DiskStamp> diskStamps;
+    QHash<QString, int> savingPaths;
     const ProjectManager *projectManager = nullptr;
 };
 
@@ -59,9 +117,27 @@ DocumentManager::DocumentManager(QWidget *parent) :
     QWidget(parent),
     priv(std::make_unique<Priv_t>())
 {
-    priv->stack = new QStackedLayout(this);
+    auto layout = new QVBoxLayout(this);
+    layout->setMargin(0);
+    priv->splitter = new QSplitter(this);
+    layout->addWidget(priv->splitter);
+    auto primary = new QWidget(priv->splitter);
+    priv->splitter->addWidget(primary);
+    priv->stack = new QStackedLayout(primary);
     priv->stack->setMargin(0);
 
+    // One watcher for all the open documents, bursts (checkouts, generators) are coalesced
+    priv->fileWatcher = new QFileSystemWatcher(this);
+    priv->changeTimer = new QTimer(this);
+    priv->changeTimer->setSingleShot(true);
+    priv->changeTimer->setInterval(EXTERNAL_CHANGE_DEBOUNCE);
+    connect(priv->changeTimer, &QTimer::timeout, this, &DocumentManager::processExternalChanges);
+    connect(priv->fileWatcher, &QFileSystemWatcher::fileChanged, this, [this](const QString& path) {
+        priv->changedPaths.insert(path);
+        priv->changeTimer->start();
+    });
+
+    DocumentEditorFactory::instance()->registerDocumentInterface(LargeFileViewer::creator());
     DocumentEditorFactory::instance()->registerDocumentInterface(CPPTextEditor::creator());
     DocumentEditorFactory::instance()->registerDocumentInterface(MarkdownEditor::creator());
     DocumentEditorFactory::instance()->registerDocumentInterface(ImageViewer::creator());
@@ -80,6 +156,9 @@ DocumentManager::DocumentManager(QWidget *parent) :
     };
     shCut("CTRL+SHIFT+X", &DocumentManager::closeCurrent);
     shCut("CTRL+SHIFT+R", &DocumentManager::reloadDocumentCurrent);
+    shCut("CTRL+ALT+H", [this]() { splitCurrent(Qt::Horizontal); });
+    shCut("CTRL+ALT+V", [this]() { splitCurrent(Qt::Vertical); });
+    shCut("CTRL+ALT+U", &DocumentManager::unsplit);
     // SHCUT("CTRL+S", &DocumentManager::saveCurrent);
 }
 
@@ -111,14 +190,15 @@ void DocumentManager::setComboBox(QComboBox *cb)
             auto path = widget->windowFilePath();
             auto iface = priv->mapedWidgets.value(path, nullptr);
             if (iface) {
-                int comboIdx = priv->combo->findData(path);
-                if (comboIdx == -1) {
-                    priv->combo->addItem(QFileInfo(path).fileName(), path);
-                    priv->combo->model()->sort(0);
-                    comboIdx = priv->combo->findData(path);
-                    priv->combo->setItemIcon(comboIdx, FileSystemManager::iconForFile(QFileInfo(path)));
-                }
-                priv->combo->setCurrentIndex(comboIdx);
+                priv->combo->setCurrentIndex(comboIndexFor(path));
+                touchDocument(path);
+            } else if (priv->deferredDocuments.contains(path)) {
+                // A restored placeholder got the focus, build the real editor
+                QPointer<QWidget> placeholder(widget);
+                QTimer::singleShot(0, this, [this, placeholder, path]() {
+                    if (placeholder && priv->stack->currentWidget() == placeholder)
+                        openDocument(path);
+                });
             }
         }
     });
@@ -140,7 +220,7 @@ QStringList DocumentManager::documents() const
 
 int DocumentManager::documentCount() const
 {
-    return priv->mapedWidgets.count();
+    return priv->mapedWidgets.count() + priv->deferredDocuments.count();
 }
 
 QString DocumentManager::documentCurrent() const
@@ -177,6 +257,17 @@ IDocumentEditor *DocumentManager::openDocument(const QString &filePath)
     }
     if (QFileInfo(path).isRelative())
         path = QDir(priv->projectManager->projectPath()).absoluteFilePath(path);
+    if (priv->pendingDocuments.contains(path)) {
+        priv->stack->setCurrentWidget(priv->pendingDocuments.value(path).placeholder);
+        return nullptr;
+    }
+    QVariantMap state;
+    if (priv->deferredDocuments.contains(path)) {
+        auto deferred = priv->deferredDocuments.take(path);
+        state = deferred.state;
+        priv->stack->removeWidget(deferred.placeholder);
+        deferred.placeholder->deleteLater();
+    }
     QWidget *widget = nullptr;
     auto item = priv->mapedWidgets.value(path, nullptr);
     if (!item) {
@@ -184,6 +275,10 @@ IDocumentEditor *DocumentManager::openDocument(const QString &filePath)
         if (item) {
             if (priv->projectManager)
                 item->setCodeModel(priv->projectManager->codeModel());
+            if (item->canAttach()) {
+                openDocumentAsync(path, item, state);
+                return nullptr;
+            }
             widget = item->widget();
             if (!item->load(path)) {
                 item->widget()->deleteLater();
@@ -191,22 +286,8 @@ IDocumentEditor *DocumentManager::openDocument(const QString &filePath)
                 widget = nullptr;
             } else {
                 item->setModified(false);
-                priv->mapedWidgets.insert(path, item);
-                priv->stack->addWidget(widget);
-                item->addModifyObserver([this](IDocumentEditor *ed, bool m) {
-                    auto path = ed->path();
-                    auto idx = priv->combo->findData(path);
-                    if (idx != -1) {
-                        priv->combo->setItemIcon(idx,
-                            m? QIcon(AppConfig::resourceImage({ "actions", "document-close" })) :
-                              FileSystemManager::iconForFile(QFileInfo(path)));
-                    }
-                    emit documentModified(path, ed, m);
-                });
-                item->addCursorObserver([this](IDocumentEditor *ed, int line, int col) {
-                    emit documentPositionModified(ed->path(), line, col);
-                });
-                item->setDocumentManager(this);
+                registerDocument(path, item);
+                item->restoreState(state);
             }
         }
     } else
@@ -222,9 +303,191 @@ IDocumentEditor *DocumentManager::openDocument(const QString &filePath)
 void DocumentManager::openDocumentHere(const QString &path, int line, int col)
 {
     qDebug() << "open document here" << path << line << col;
-    auto ed = openDocument(path);
-    if (ed)
-        ed->setCursor({ col, line });
+    openDocument(path);
+    auto absPath = absoluteTo(priv->projectManager->projectPath(), path);
+    if (priv->pendingDocuments.contains(absPath)) {
+        auto& pending = priv->pendingDocuments[absPath];
+        pending.cursor = { col, line };
+        pending.hasCursor = true;
+    } else {
+        auto ed = priv->mapedWidgets.value(absPath, nullptr);
+        if (ed)
+            ed->setCursor({ col, line });
+    }
+}
+
+void DocumentManager::openDocumentAsync(const QString &path, IDocumentEditor *item, const QVariantMap &state)
+{
+    // Read and decode run in background, only attach the buffer on GUI thread
+    auto placeholder = new QLabel(tr("Loading %1...").arg(QFileInfo(path).fileName()), this);
+    placeholder->setAlignment(Qt::AlignCenter);
+    placeholder->setWindowFilePath(path);
+    item->widget()->hide();
+    priv->stack->addWidget(placeholder);
+    priv->stack->setCurrentWidget(placeholder);
+    PendingDocument pending;
+    pending.editor = item;
+    pending.placeholder = placeholder;
+    pending.state = state;
+    priv->pendingDocuments.insert(path, pending);
+
+    auto watcher = new QFutureWatcher<DocumentBuffer>(this);
+    connect(watcher, &QFutureWatcher<DocumentBuffer>::finished, this, [this, watcher, path, item]() {
+        watcher->deleteLater();
+        if (priv->pendingDocuments.value(path).editor != item)
+            return; // Closed while loading
+        auto pending = priv->pendingDocuments.take(path);
+        auto buffer = watcher->result();
+        bool isCurrent = priv->stack->currentWidget() == pending.placeholder;
+        if (!item->attach(buffer)) {
+            TextMessageBrocker::instance().publish(TextMessages::STDERR_LOG,
+                                                   tr("Cannot open %1: %2").arg(path, buffer.errorString));
+            priv->stack->removeWidget(pending.placeholder);
+            pending.placeholder->deleteLater();
+            item->widget()->deleteLater();
+            emit documentNotFound(path);
+            return;
+        }
+        item->setModified(false);
+        registerDocument(path, item);
+        if (isCurrent) {
+            priv->stack->setCurrentWidget(item->widget());
+            emit documentFocushed(path);
+        }
+        priv->stack->removeWidget(pending.placeholder);
+        pending.placeholder->deleteLater();
+        item->restoreState(pending.state);
+        if (pending.hasCursor)
+            item->setCursor(pending.cursor);
+        unloadInactiveDocuments();
+    });
+    watcher->setFuture(DocumentIO::readAsync(path));
+}
+
+int DocumentManager::comboIndexFor(const QString &path)
+{
+    int comboIdx = priv->combo->findData(path);
+    if (comboIdx == -1) {
+        QSignalBlocker blocker(priv->combo);
+        priv->combo->addItem(QFileInfo(path).fileName(), path);
+        priv->combo->model()->sort(0);
+        comboIdx = priv->combo->findData(path);
+        priv->combo->setItemIcon(comboIdx, FileSystemManager::iconForFile(QFileInfo(path)));
+    }
+    return comboIdx;
+}
+
+void DocumentManager::addDeferredDocument(const QString &path, const QVariantMap &state)
+{
+    auto placeholder = new QLabel(QFileInfo(path).fileName(), this);
+    placeholder->setAlignment(Qt::AlignCenter);
+    placeholder->setWindowFilePath(path);
+    priv->stack->addWidget(placeholder);
+    DeferredDocument deferred;
+    deferred.placeholder = placeholder;
+    deferred.state = state;
+    priv->deferredDocuments.insert(path, deferred);
+    if (priv->combo)
+        comboIndexFor(path);
+}
+
+void DocumentManager::touchDocument(const QString &path)
+{
+    priv->recentlyUsed.removeAll(path);
+    priv->recentlyUsed.prepend(path);
+    unloadInactiveDocuments();
+}
+
+void DocumentManager::unloadInactiveDocuments()
+{
+    const int budget = AppConfig::instance().editorMaxLiveDocuments();
+    if (budget <= 0)
+        return;
+    // Least recently used unmodified editors are replaced by a placeholder with their state
+    for(int i = priv->recentlyUsed.count() - 1; i > 0 && priv->mapedWidgets.count() > budget; i--) {
+        auto path = priv->recentlyUsed.at(i);
+        auto iface = priv->mapedWidgets.value(path, nullptr);
+        if (!iface || iface->isModified() || path == priv->splitPath ||
+                iface->widget() == priv->stack->currentWidget())
+            continue;
+        auto state = iface->saveState();
+        priv->mapedWidgets.remove(path);
+        priv->recentlyUsed.removeAt(i);
+        watchDocument(path, false);
+        priv->stack->removeWidget(iface->widget());
+        iface->widget()->deleteLater();
+        addDeferredDocument(path, state);
+    }
+}
+
+void DocumentManager::registerDocument(const QString &path, IDocumentEditor *item)
+{
+    priv->mapedWidgets.insert(path, item);
+    // Least recently used until it gets the focus
+    if (!priv->recentlyUsed.contains(path))
+        priv->recentlyUsed.append(path);
+    priv->stack->addWidget(item->widget());
+    // Documents loaded in background are not current, still reachable from the combo
+    if (priv->combo)
+        comboIndexFor(path);
+    item->addModifyObserver([this](IDocumentEditor *ed, bool m) {
+        auto path = ed->path();
+        auto idx = priv->combo->findData(path);
+        if (idx != -1) {
+            priv->combo->setItemIcon(idx,
+                m? QIcon(AppConfig::resourceImage({ "actions", "document-close" })) :
+                  FileSystemManager::iconForFile(QFileInfo(path)));
+        }
+        emit documentModified(path, ed, m);
+    });
+    item->addCursorObserver([this](IDocumentEditor *ed, int line, int col) {
+        emit documentPositionModified(ed->path(), line, col);
+    });
+    item->setDocumentManager(this);
+    watchDocument(path, true);
+}
+
+void DocumentManager::watchDocument(const QString &path, bool enable)
+{
+    if (enable) {
+        priv->diskStamps.insert(path, DiskStamp::of(path));
+        priv->fileWatcher->addPath(path);
+    } else {
+        priv->diskStamps.remove(path);
+        priv->fileWatcher->removePath(path);
+    }
+}
+
+void DocumentManager::processExternalChanges()
+{
+    const auto paths = priv->changedPaths;
+    priv->changedPaths.clear();
+    for(const auto& path: paths) {
+        auto iface = priv->mapedWidgets.value(path, nullptr);
+        if (!iface)
+            continue;
+        // Replaced files (rename over the original) drop out of the watcher
+        if (QFileInfo::exists(path) && !priv->fileWatcher->files().contains(path))
+            priv->fileWatcher->addPath(path);
+        if (priv->savingPaths.contains(path))
+            continue;
+        auto stamp = DiskStamp::of(path);
+        if (!stamp.isValid() || stamp == priv->diskStamps.value(path))
+            continue;
+        priv->diskStamps.insert(path, stamp);
+        if (iface->isModified()) {
+            QMessageBox messageBox(QMessageBox::Question,
+                                   tr("Document Changed"),
+                                   tr("%1 was changed outside the editor. Reload it and lose your changes?").arg(path),
+                                   QMessageBox::Yes | QMessageBox::No,
+                                   this);
+            messageBox.setButtonText(QMessageBox::Yes, tr("Yes"));
+            messageBox.setButtonText(QMessageBox::No, tr("No"));
+            if (messageBox.exec() != QMessageBox::Yes)
+                continue;
+        }
+        reloadDocument(path);
+    }
 }
 
 bool DocumentManager::closeDocument(const QString &filePath)
@@ -233,6 +496,26 @@ bool DocumentManager::closeDocument(const QString &filePath)
     // Cannot save due not name on path
     if (path.isEmpty())
         return true;
+    if (priv->pendingDocuments.contains(path)) {
+        auto pending = priv->pendingDocuments.take(path);
+        priv->stack->removeWidget(pending.placeholder);
+        pending.placeholder->deleteLater();
+        pending.editor->widget()->deleteLater();
+        emit documentClosed(path);
+        return true;
+    }
+    if (priv->deferredDocuments.contains(path)) {
+        auto deferred = priv->deferredDocuments.take(path);
+        priv->stack->removeWidget(deferred.placeholder);
+        deferred.placeholder->deleteLater();
+        if (priv->combo) {
+            int idx = priv->combo->findData(path);
+            if (idx != -1)
+                priv->combo->removeItem(idx);
+        }
+        emit documentClosed(path);
+        return true;
+    }
     // Cannot save due not in map (not widget interface registered)
     auto iface = priv->mapedWidgets.value(path);
     if (!iface)
@@ -246,6 +529,10 @@ bool DocumentManager::closeDocument(const QString &filePath)
         }
         iface->widget()->deleteLater();
         priv->mapedWidgets.remove(path);
+        priv->recentlyUsed.removeAll(path);
+        watchDocument(path, false);
+        if (path == priv->splitPath)
+            unsplit();
         emit documentClosed(path);
         return true;
     }
@@ -254,6 +541,10 @@ bool DocumentManager::closeDocument(const QString &filePath)
 
 bool DocumentManager::closeAll()
 {
+    for(const auto& path: priv->pendingDocuments.keys())
+        closeDocument(path);
+    for(const auto& path: priv->deferredDocuments.keys())
+        closeDocument(path);
     const auto keys = priv->mapedWidgets.keys();
     for(const auto& path: keys)
         if (!closeDocument(path))
@@ -269,7 +560,19 @@ bool DocumentManager::aboutToCloseAll()
     }
     UnsavedFilesDialog d(unsaved, this);
     if (d.exec() == QDialog::Accepted) {
-        saveDocuments(d.checkedForSave());
+        // Closing drops the editors, so the chosen documents must reach the disk first
+        bool pending = true;
+        bool saved = false;
+        QEventLoop loop;
+        saveDocuments(d.checkedForSave(), [&pending, &saved, &loop](bool ok) {
+            pending = false;
+            saved = ok;
+            loop.quit();
+        });
+        if (pending)
+            loop.exec(QEventLoop::ExcludeUserInputEvents);
+        if (!saved)
+            return false;
         for(const auto& doc: unsavedDocuments()) {
             auto iface = documentEditor(doc);
             if (iface)
@@ -284,17 +587,64 @@ void DocumentManager::saveDocument(const QString &path)
 {
     if (path.isEmpty())
         return;
-    auto iface = priv->mapedWidgets.value(absoluteTo(priv->projectManager->projectPath(), path));
-    if (!iface)
-        return;
-    iface->save(iface->path());
+    saveDocuments({ path });
+}
+
+void DocumentManager::saveDocuments(const QStringList &list, const std::function<void (bool)> &finished)
+{
+    // Buffers are captured here, all the writes run at once on the I/O pool
+    auto remaining = std::make_shared<int>(1);
+    auto allSaved = std::make_shared<bool>(true);
+    auto done = [remaining, allSaved, finished]() {
+        if (--*remaining == 0 && finished)
+            finished(*allSaved);
+    };
+    for(const auto& p: list) {
+        auto iface = priv->mapedWidgets.value(absoluteTo(priv->projectManager->projectPath(), p));
+        if (!iface)
+            continue;
+        if (!iface->canSnapshot()) {
+            if (!iface->save(iface->path()))
+                *allSaved = false;
+            priv->diskStamps.insert(iface->path(), DiskStamp::of(iface->path()));
+            continue;
+        }
+        // The document stays modified, and journaled, until the write is committed
+        auto buffer = iface->snapshot();
+        auto revision = iface->revision();
+        ++*remaining;
+        priv->savingPaths[buffer.path]++;
+        auto watcher = new QFutureWatcher<QString>(this);
+        connect(watcher, &QFutureWatcher<QString>::finished, this, [this, watcher, path = buffer.path, revision, allSaved, done]() {
+            watcher->deleteLater();
+            // Own writes are not external changes
+            if (--priv->savingPaths[path] == 0)
+                priv->savingPaths.remove(path);
+            if (priv->mapedWidgets.contains(path)) {
+                priv->diskStamps.insert(path, DiskStamp::of(path));
+                if (!priv->fileWatcher->files().contains(path))
+                    priv->fileWatcher->addPath(path);
+            }
+            auto error = watcher->result();
+            auto ed = priv->mapedWidgets.value(path, nullptr);
+            if (!error.isEmpty()) {
+                *allSaved = false;
+                TextMessageBrocker::instance().publish(TextMessages::STDERR_LOG,
+                                                       tr("Cannot save %1: %2").arg(path, error));
+            } else if (ed && ed->revision() == revision) {
+                // Not when edited while writing, the disk has an older text then
+                ed->setModified(false);
+            }
+            done();
+        });
+        watcher->setFuture(DocumentIO::writeAsync(buffer));
+    }
+    done();
 }
 
 void DocumentManager::saveAll()
 {
-    const auto keys = priv->mapedWidgets.keys();
-    for(const auto& path: keys)
-        saveDocument(path);
+    saveDocuments(unsavedDocuments());
 }
 
 void DocumentManager::reloadDocument(const QString &path)
@@ -307,6 +657,85 @@ void DocumentManager::reloadDocument(const QString &path)
     iface->reload();
 }
 
+QJsonObject DocumentManager::saveSession() const
+{
+    QJsonArray docs;
+    auto append = [&docs](const QString& path, const QVariantMap& state) {
+        docs.append(QJsonObject{
+            { "path", path },
+            { "state", QJsonObject::fromVariantMap(state) },
+        });
+    };
+    for(auto it = priv->mapedWidgets.cbegin(); it != priv->mapedWidgets.cend(); ++it)
+        append(it.key(), it.value()->saveState());
+    for(auto it = priv->pendingDocuments.cbegin(); it != priv->pendingDocuments.cend(); ++it)
+        append(it.key(), it.value().state);
+    for(auto it = priv->deferredDocuments.cbegin(); it != priv->deferredDocuments.cend(); ++it)
+        append(it.key(), it.value().state);
+    auto current = priv->stack->currentWidget();
+    return QJsonObject{
+        { "documents", docs },
+        { "current", current? current->windowFilePath() : QString() },
+    };
+}
+
+void DocumentManager::restoreSession(const QJsonObject &session)
+{
+    // Only placeholders are created here, editors are built when focused
+    for(const auto& v: session.value("documents").toArray()) {
+        auto doc = v.toObject();
+        auto path = doc.value("path").toString();
+        if (!QFileInfo(path).isFile() ||
+                priv->mapedWidgets.contains(path) ||
+                priv->pendingDocuments.contains(path) ||
+                priv->deferredDocuments.contains(path))
+            continue;
+        addDeferredDocument(path, doc.value("state").toObject().toVariantMap());
+    }
+    auto current = session.value("current").toString();
+    if (priv->deferredDocuments.contains(current))
+        openDocument(current);
+}
+
+void DocumentManager::splitCurrent(Qt::Orientation orientation)
+{
+    auto path = documentCurrent();
+    auto source = priv->mapedWidgets.value(path, nullptr);
+    if (!source)
+        return;
+    priv->splitter->setOrientation(orientation);
+    if (priv->splitView && priv->splitPath == path)
+        return;
+    unsplit();
+    // The view only attaches to the document of the opened editor, nothing is loaded twice
+    auto view = DocumentEditorFactory::instance()->create(path, priv->splitter);
+    if (!view)
+        return;
+    // Saves go through the manager, the watcher must know the write is ours
+    view->setDocumentManager(this);
+    if (!view->attachView(source)) {
+        view->widget()->deleteLater();
+        TextMessageBrocker::instance().publish(TextMessages::STDERR_LOG, tr("%1 cannot be split").arg(path));
+        return;
+    }
+    view->restoreState(source->saveState());
+    priv->splitter->addWidget(view->widget());
+    priv->splitView = view;
+    priv->splitPath = path;
+    view->widget()->setFocus();
+}
+
+void DocumentManager::unsplit()
+{
+    if (!priv->splitView)
+        return;
+    auto w = priv->splitView->widget();
+    w->hide();
+    w->deleteLater();
+    priv->splitView = nullptr;
+    priv->splitPath.clear();
+}
+
 void DocumentManager::focusInEvent(QFocusEvent *event)
 {
     Q_UNUSED(event);
@@ -20,7 +20,9 @@
 #define DOCUMENTMANAGER_H
 
 #include <QWidget>
+#include <QJsonObject>
 
+#include <functional>
 #include <memory>
 
 class IDocumentEditor;
@@ -46,6 +48,10 @@ public:
 
     void setProjectManager(const ProjectManager *projectManager);
 
+    QJsonObject saveSession() const;
+
+    void saveDocuments(const QStringList& list, const std::function<void (bool ok)>& finished);
+
 signals:
     void documentFocushed(const QString& path);
     void documentNotFound(const QString& path);
@@ -61,16 +67,28 @@ public slots:
     bool closeAll();
     bool aboutToCloseAll();
     void saveDocument(const QString& path);
-    void saveDocuments(const QStringList& list) { for(const auto& a: list) saveDocument(a); }
+    void saveDocuments(const QStringList& list) { saveDocuments(list, nullptr); }
     void saveCurrent() { saveDocument(documentCurrent()); }
     void saveAll();
     void reloadDocument(const QString& path);
     void reloadDocumentCurrent() { reloadDocument(documentCurrent()); }
+    void restoreSession(const QJsonObject& session);
+    void splitCurrent(Qt::Orientation orientation);
+    void unsplit();
 
 protected:
     void focusInEvent(QFocusEvent *event) override;
 
 private:
+    void openDocumentAsync(const QString& path, IDocumentEditor *item, const QVariantMap& state);
+    int comboIndexFor(const QString& path);
+    void addDeferredDocument(const QString& path, const QVariantMap& state);
+    void touchDocument(const QString& path);
+    void unloadInactiveDocuments();
+    void watchDocument(const QString& path, bool enable);
+    void processExternalChanges();
+    void registerDocument(const QString& path, IDocumentEditor *item);
+
     class Priv_t;
     std::unique_ptr<Priv_t> priv;
 };
@@ -0,0 +1,265 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "editjournal.h"
+#include "appconfig.h"
+#include "documentio.h"
+
+#include <Qsci/qsciscintilla.h>
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QLockFile>
+
+static const QByteArray JOURNAL_MAGIC = "EIDEJRN1";
+static const QString JOURNAL_SUFFIX = "journal";
+static constexpr int COMMIT_INTERVAL = 300;
+
+static constexpr char OP_INSERT = 'I';
+static constexpr char OP_DELETE = 'D';
+
+static void putVarint(QByteArray& out, quint64 value)
+{
+    while (value >= 0x80) {
+        out.append(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.append(static_cast<char>(value));
+}
+
+static bool getVarint(const QByteArray& in, int& offset, quint64& value)
+{
+    value = 0;
+    for(int shift = 0; offset < in.size() && shift < 64; shift += 7) {
+        auto byte = static_cast<quint8>(in.at(offset++));
+        value |= static_cast<quint64>(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+static QByteArray baseDigest(const char *data, int size)
+{
+    return QCryptographicHash::hash(QByteArray::fromRawData(data, size), QCryptographicHash::Md5);
+}
+
+EditJournal::EditJournal(QsciScintilla *editor) :
+    QObject(editor),
+    editor(editor)
+{
+    commitTimer.setSingleShot(true);
+    commitTimer.setInterval(COMMIT_INTERVAL);
+    connect(&commitTimer, &QTimer::timeout, this, &EditJournal::commit);
+    connect(editor, &QsciScintillaBase::SCN_MODIFIED,
+            [this](int position, int type, const char *text, int length) {
+        onModified(position, type, text, length);
+    });
+    connect(editor, &QsciScintilla::modificationChanged, [this](bool m) {
+        // Back on the save point, the disk already has the content
+        if (!m)
+            discard();
+    });
+}
+
+EditJournal::~EditJournal()
+{
+    discard();
+}
+
+static QString journalRoot()
+{
+    return AppConfig::ensureExist(QDir(AppConfig::instance().workspacePath()).filePath("journal"));
+}
+
+static QString instanceName()
+{
+    return QString::number(QCoreApplication::applicationPid());
+}
+
+QString EditJournal::journalPath()
+{
+    // Each running IDE writes in its own directory, owned while the lock is held
+    static QLockFile owner(QDir(journalRoot()).filePath(instanceName() + ".lock"));
+    if (!owner.isLocked())
+        owner.tryLock(0);
+    return AppConfig::ensureExist(QDir(journalRoot()).filePath(instanceName()));
+}
+
+QStringList EditJournal::pendingJournals()
+{
+    // The journals of dead instances are adopted, the live ones are left alone
+    QDir root(journalRoot());
+    QDir own(journalPath());
+    for(const auto& name: root.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        if (name == instanceName())
+            continue;
+        QLockFile lock(root.filePath(name + ".lock"));
+        lock.setStaleLockTime(0);
+        if (!lock.tryLock(0))
+            continue;
+        QDir orphan(root.filePath(name));
+        for(const auto& journal: orphan.entryList({ QString("*.%1").arg(JOURNAL_SUFFIX) }, QDir::Files))
+            QFile::rename(orphan.filePath(journal), own.filePath(QString("%1-%2").arg(name, journal)));
+        orphan.removeRecursively();
+        lock.unlock();
+    }
+
+    QStringList list;
+    for(const auto& name: own.entryList({ QString("*-*.%1").arg(JOURNAL_SUFFIX) }, QDir::Files))
+        list.append(own.absoluteFilePath(name));
+    return list;
+}
+
+EditJournal::Recovery EditJournal::replay(const QString &journalFile)
+{
+    Recovery r;
+    QFile f(journalFile);
+    if (!f.open(QFile::ReadOnly)) {
+        r.errorString = f.errorString();
+        return r;
+    }
+    auto data = f.readAll();
+    if (!data.startsWith(JOURNAL_MAGIC)) {
+        r.errorString = tr("Invalid journal");
+        return r;
+    }
+    int offset = JOURNAL_MAGIC.size();
+    quint64 pathSize;
+    quint64 baseSize;
+    if (!getVarint(data, offset, pathSize) || offset + static_cast<qint64>(pathSize) > data.size()) {
+        r.errorString = tr("Invalid journal");
+        return r;
+    }
+    r.path = QString::fromUtf8(data.mid(offset, static_cast<int>(pathSize)));
+    offset += static_cast<int>(pathSize);
+    if (!getVarint(data, offset, baseSize) || offset + 16 > data.size()) {
+        r.errorString = tr("Invalid journal");
+        return r;
+    }
+    auto digest = data.mid(offset, 16);
+    offset += 16;
+
+    auto base = DocumentIO::read(r.path, AppConfig::instance().editorTabWidth());
+    if (!base.valid) {
+        r.errorString = base.errorString;
+        return r;
+    }
+    if (static_cast<quint64>(base.bytes.size()) != baseSize ||
+            baseDigest(base.bytes.constData(), base.bytes.size()) != digest) {
+        r.errorString = tr("%1 changed on disk after the journal was started").arg(r.path);
+        return r;
+    }
+    r.text = base.bytes;
+    // A record cut by the crash ends the replay, everything before it is intact
+    while (offset < data.size()) {
+        char op = data.at(offset++);
+        quint64 position;
+        quint64 length;
+        if (!getVarint(data, offset, position) || !getVarint(data, offset, length))
+            break;
+        if (position > static_cast<quint64>(r.text.size()))
+            break;
+        if (op == OP_INSERT) {
+            if (offset + static_cast<qint64>(length) > data.size())
+                break;
+            r.text.insert(static_cast<int>(position), data.constData() + offset, static_cast<int>(length));
+            offset += static_cast<int>(length);
+        } else if (op == OP_DELETE) {
+            if (position + length > static_cast<quint64>(r.text.size()))
+                break;
+            r.text.remove(static_cast<int>(position), static_cast<int>(length));
+        } else
+            break;
+    }
+    r.valid = true;
+    return r;
+}
+
+void EditJournal::setRecording(bool enable)
+{
+    recording = enable;
+}
+
+void EditJournal::discard()
+{
+    commitTimer.stop();
+    pending.clear();
+    if (file.isOpen()) {
+        file.close();
+        file.remove();
+    }
+}
+
+void EditJournal::commit()
+{
+    // Group commit: all the keystrokes since the last timeout go in one write
+    if (!file.isOpen() || pending.isEmpty())
+        return;
+    file.write(pending);
+    file.flush();
+    pending.clear();
+}
+
+void EditJournal::onModified(int position, int type, const char *text, int length)
+{
+    if (!recording || editor->windowFilePath().isEmpty())
+        return;
+    if (type & (QsciScintillaBase::SC_MOD_BEFOREINSERT | QsciScintillaBase::SC_MOD_BEFOREDELETE)) {
+        if (!file.isOpen())
+            open();
+        return;
+    }
+    if (!file.isOpen())
+        return;
+    if (type & QsciScintillaBase::SC_MOD_INSERTTEXT) {
+        pending.append(OP_INSERT);
+        putVarint(pending, static_cast<quint64>(position));
+        putVarint(pending, static_cast<quint64>(length));
+        pending.append(text, length);
+    } else if (type & QsciScintillaBase::SC_MOD_DELETETEXT) {
+        pending.append(OP_DELETE);
+        putVarint(pending, static_cast<quint64>(position));
+        putVarint(pending, static_cast<quint64>(length));
+    } else
+        return;
+    if (!commitTimer.isActive())
+        commitTimer.start();
+}
+
+bool EditJournal::open()
+{
+    auto path = editor->windowFilePath();
+    auto name = QCryptographicHash::hash(path.toUtf8(), QCryptographicHash::Sha1).toHex();
+    file.setFileName(QDir(journalPath()).filePath(QString("%1.%2").arg(QString(name), JOURNAL_SUFFIX)));
+    if (!file.open(QFile::WriteOnly | QFile::Truncate))
+        return false;
+    // The base is the buffer before the first change, it must match the disk on replay
+    auto size = static_cast<int>(editor->SendScintilla(QsciScintillaBase::SCI_GETLENGTH));
+    auto data = static_cast<const char*>(editor->SendScintillaPtrResult(QsciScintillaBase::SCI_GETCHARACTERPOINTER));
+    QByteArray header = JOURNAL_MAGIC;
+    auto utf8Path = path.toUtf8();
+    putVarint(header, static_cast<quint64>(utf8Path.size()));
+    header.append(utf8Path);
+    putVarint(header, static_cast<quint64>(size));
+    header.append(baseDigest(data, size));
+    file.write(header);
+    file.flush();
+    return true;
+}
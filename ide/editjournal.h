@@ -0,0 +1,64 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef EDITJOURNAL_H
+#define EDITJOURNAL_H
+
+#include <QFile>
+#include <QObject>
+#include <QTimer>
+
+class QsciScintilla;
+
+class EditJournal : public QObject
+{
+    Q_OBJECT
+public:
+    struct Recovery {
+        QString path;
+        QByteArray text;
+        bool valid = false;
+        QString errorString;
+    };
+
+    explicit EditJournal(QsciScintilla *editor);
+    ~EditJournal() override;
+
+    static QString journalPath();
+    static QStringList pendingJournals();
+    static Recovery replay(const QString& journalFile);
+
+public slots:
+    void setRecording(bool enable);
+    void discard();
+
+private slots:
+    void commit();
+
+private:
+    void onModified(int position, int type, const char *text, int length);
+    bool open();
+
+    QsciScintilla *editor;
+    QFile file;
+    QByteArray pending;
+    QTimer commitTimer;
+    bool recording = true;
+};
+
+#endif // EDITJOURNAL_H
@@ -0,0 +1,359 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "filecompiler.h"
+#include "childprocess.h"
+#include "projectmanager.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPointer>
+#include <QRegularExpression>
+#include <QSet>
+
+#include <QtDebug>
+
+static const QHash<QString, QString> C_LOCALE{ { "LC_ALL", "C" }, { "LANG", "C" } };
+
+class FileCompiler::Priv_t
+{
+public:
+    ProjectManager *project{ nullptr };
+    QHash<QString, CompileCommand> commands;
+    QHash<QString, QList<CommandCallback_t>> waiting;
+    QDateTime stamp;
+    QSet<int> pending;
+    QHash<int, QPointer<QProcess>> processes;
+    int nextTicket = 1;
+
+    QString databasePath() const { return QDir(project->projectPath()).filePath("compile_commands.json"); }
+
+    // Commands are valid while the makefile and the database are untouched
+    QDateTime sourcesStamp() const {
+        auto a = QFileInfo(project->projectFile()).lastModified();
+        auto b = QFileInfo(databasePath()).lastModified();
+        return b.isValid() && b > a? b : a;
+    }
+};
+
+static bool isSeparator(const QString& token)
+{
+    return token == ";" || token == "&&" || token == "||" || token == "|" || token == "&";
+}
+
+static bool isCompiler(const QString& program)
+{
+    static const QRegularExpression re(R"(^(?:.*-)?(?:gcc|g\+\+|cc|c\+\+|clang|clang\+\+)(?:-[\d.]+)?(?:\.exe)?$)");
+    return re.match(QFileInfo(program).fileName()).hasMatch();
+}
+
+QString FileCompiler::languageOf(const QString& file)
+{
+    auto suffix = QFileInfo(file).suffix();
+    if (suffix == "S" || suffix == "sx")
+        return "assembler-with-cpp";
+    if (suffix == "s")
+        return "assembler";
+    if (QStringList{ "cpp", "cc", "cxx", "c++", "C", "CPP" }.contains(suffix))
+        return "c++";
+    return "c";
+}
+
+FileCompiler::FileCompiler(ProjectManager *proj, QObject *parent) :
+    QObject(parent),
+    priv(std::make_unique<Priv_t>())
+{
+    priv->project = proj;
+    connect(proj, &ProjectManager::projectOpened, this, &FileCompiler::invalidate);
+    connect(proj, &ProjectManager::projectClosed, this, &FileCompiler::invalidate);
+}
+
+FileCompiler::~FileCompiler() = default;
+
+void FileCompiler::invalidate()
+{
+    priv->commands.clear();
+    priv->stamp = QDateTime();
+}
+
+void FileCompiler::commandFor(const QString &path, CommandCallback_t cb)
+{
+    auto file = QDir::cleanPath(QFileInfo(path).absoluteFilePath());
+    auto stamp = priv->sourcesStamp();
+    if (stamp != priv->stamp) {
+        priv->commands.clear();
+        priv->stamp = stamp;
+    }
+    auto it = priv->commands.constFind(file);
+    if (it != priv->commands.constEnd()) {
+        cb(*it);
+        return;
+    }
+    QFile db(priv->databasePath());
+    if (db.open(QFile::ReadOnly)) {
+        auto cmd = fromDatabase(db.readAll(), file);
+        if (cmd.isValid()) {
+            priv->commands.insert(file, cmd);
+            cb(cmd);
+            return;
+        }
+    }
+
+    auto& waiting = priv->waiting[file];
+    waiting.append(cb);
+    if (waiting.size() > 1)
+        return; // A dry run for this file is on its way
+    QDir root(priv->project->projectPath());
+    // Only the object depending on the file is remade, when make knows it
+    auto targets = priv->project->targetsOfDependency(root.relativeFilePath(file)) +
+                   priv->project->targetsOfDependency(file);
+    auto& p = ChildProcess::create(this)
+            .makeDeleteLater()
+            .changeCWD(root.absolutePath())
+            .setenv(C_LOCALE)
+            .onError([this, file](QProcess *make, QProcess::ProcessError err) {
+        if (err == QProcess::FailedToStart) {
+            qDebug() << "make dry run error:" << make->errorString();
+            resolve(file, CompileCommand());
+        }
+    }).onFinished([this, file](QProcess *make, int exitCode) {
+        Q_UNUSED(exitCode)
+        resolve(file, fromDryRun(make->readAllStandardOutput(), make->workingDirectory(), file));
+    });
+    p.start("make", QStringList{ "-B", "-n", "-w", "-f", priv->project->projectFile() } + targets);
+}
+
+void FileCompiler::resolve(const QString &file, const CompileCommand &cmd)
+{
+    if (cmd.isValid())
+        priv->commands.insert(file, cmd);
+    for (const auto& cb: priv->waiting.take(file))
+        cb(cmd);
+}
+
+int FileCompiler::compile(const QString &path, const QByteArray &unsaved, bool syntaxOnly, ResultCallback_t cb, const QStringList &extraArgs)
+{
+    return run(path, unsaved, [syntaxOnly, unsaved, extraArgs](const CompileCommand& cmd) {
+        return checkArguments(cmd, syntaxOnly, !unsaved.isNull(), extraArgs);
+    }, cb);
+}
+
+int FileCompiler::precompile(const QString &path, const QString &header, const QString &output, ResultCallback_t cb)
+{
+    return run(path, QByteArray(), [header, output](const CompileCommand& cmd) {
+        auto lang = languageOf(cmd.file);
+        if (lang != "c" && lang != "c++")
+            return QStringList();
+        // The header is not next to the source, its quoted includes are
+        return baseArguments(cmd) << "-iquote" << QFileInfo(cmd.file).absolutePath()
+                                  << "-x" << QString("%1-header").arg(lang) << header << "-o" << output;
+    }, cb);
+}
+
+void FileCompiler::cancel(int ticket)
+{
+    if (!priv->pending.remove(ticket))
+        return;
+    auto p = priv->processes.take(ticket);
+    if (p)
+        p->kill();
+}
+
+int FileCompiler::run(const QString &path, const QByteArray &input,
+                      const std::function<QStringList (const CompileCommand &)> &arguments, ResultCallback_t cb)
+{
+    int ticket = priv->nextTicket++;
+    priv->pending.insert(ticket);
+    commandFor(path, [this, ticket, path, input, arguments, cb](const CompileCommand& cmd) {
+        if (!priv->pending.contains(ticket))
+            return;
+        auto args = cmd.isValid()? arguments(cmd) : QStringList();
+        if (args.isEmpty()) {
+            priv->pending.remove(ticket);
+            cb(-1, tr("No compile command found for %1\n").arg(path).toLocal8Bit());
+            return;
+        }
+        auto& p = ChildProcess::create(this)
+                .makeDeleteLater()
+                .changeCWD(cmd.directory)
+                .mergeStdOutAndErr()
+                .setenv(C_LOCALE)
+                .onStarted([input](QProcess *cc) {
+            if (!input.isNull())
+                cc->write(input);
+            cc->closeWriteChannel();
+        }).onError([this, ticket, cb](QProcess *cc, QProcess::ProcessError err) {
+            if (err == QProcess::FailedToStart && priv->pending.remove(ticket)) {
+                priv->processes.remove(ticket);
+                cb(-1, cc->errorString().toLocal8Bit());
+            }
+        }).onFinished([this, ticket, cb, path](QProcess *cc, int exitCode) {
+            priv->processes.remove(ticket);
+            if (!priv->pending.remove(ticket))
+                return;
+            // Diagnostics of the buffer point to the real file
+            cb(exitCode, cc->readAll().replace("<stdin>", path.toLocal8Bit()));
+        });
+        priv->processes.insert(ticket, &p);
+        p.start(cmd.compiler, args);
+    });
+    return ticket;
+}
+
+QStringList FileCompiler::tokenize(const QString &line)
+{
+    QStringList tokens;
+    QString token;
+    bool inToken = false;
+    QChar quote;
+    for (int i = 0; i < line.size(); i++) {
+        auto c = line.at(i);
+        if (!quote.isNull()) {
+            if (c == quote)
+                quote = QChar();
+            else if (c == '\\' && quote == '"' && i + 1 < line.size() && QString("\"\\$`").contains(line.at(i + 1)))
+                token += line.at(++i);
+            else
+                token += c;
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+            inToken = true;
+        } else if (c == '\\' && i + 1 < line.size()) {
+            token += line.at(++i);
+            inToken = true;
+        } else if (c.isSpace() || c == ';' || c == '&' || c == '|') {
+            if (inToken)
+                tokens.append(token);
+            token.clear();
+            inToken = false;
+            if (!c.isSpace()) {
+                QString op(c);
+                if (c != ';' && i + 1 < line.size() && line.at(i + 1) == c)
+                    op += line.at(++i);
+                tokens.append(op);
+            }
+        } else {
+            token += c;
+            inToken = true;
+        }
+    }
+    if (inToken)
+        tokens.append(token);
+    return tokens;
+}
+
+CompileCommand FileCompiler::fromDatabase(const QByteArray &json, const QString &file)
+{
+    for (const auto& v: QJsonDocument::fromJson(json).array()) {
+        auto o = v.toObject();
+        QDir dir(o.value("directory").toString());
+        if (QDir::cleanPath(dir.absoluteFilePath(o.value("file").toString())) != file)
+            continue;
+        QStringList args;
+        if (o.contains("arguments")) {
+            for (const auto& a: o.value("arguments").toArray())
+                args.append(a.toString());
+        } else {
+            args = tokenize(o.value("command").toString());
+        }
+        if (args.isEmpty())
+            continue;
+        return CompileCommand{ dir.absolutePath(), args.first(), args.mid(1), file };
+    }
+    return CompileCommand();
+}
+
+CompileCommand FileCompiler::fromDryRun(const QString &output, const QString &directory, const QString &file)
+{
+    static const QRegularExpression dirRe(R"(^make(?:\[\d+\])?: (Entering|Leaving) directory [`'](.*)'$)");
+    QStringList dirs{ directory };
+    auto text = QString(output).replace("\\\n", " ");
+    for (const auto& line: text.split('\n')) {
+        if (line.startsWith("make")) {
+            auto m = dirRe.match(line);
+            if (m.hasMatch()) {
+                if (m.captured(1) == "Entering")
+                    dirs.append(m.captured(2));
+                else if (dirs.size() > 1)
+                    dirs.removeLast();
+                continue;
+            }
+        }
+        auto tokens = tokenize(line);
+        QDir dir(dirs.last());
+        // Recipes like "mkdir -p obj && gcc ..." hold several commands
+        int begin = 0;
+        for (int i = 0; i <= tokens.size(); i++) {
+            if (i < tokens.size() && !isSeparator(tokens.at(i)))
+                continue;
+            auto cmd = tokens.mid(begin, i - begin);
+            begin = i + 1;
+            if (cmd.size() < 2 || !isCompiler(cmd.first()))
+                continue;
+            for (const auto& arg: cmd.mid(1))
+                if (!arg.startsWith('-') && QDir::cleanPath(dir.absoluteFilePath(arg)) == file)
+                    return CompileCommand{ dir.absolutePath(), cmd.first(), cmd.mid(1), file };
+        }
+    }
+    return CompileCommand();
+}
+
+QStringList FileCompiler::baseArguments(const CompileCommand &cmd)
+{
+    static const QRegularExpression depFlag(R"(^-(?:M|MM|MD|MMD|MG|MP)$)");
+    static const QRegularExpression depFile(R"(^-M[FTQ])");
+    QDir dir(cmd.directory);
+    QStringList args;
+    for (int i = 0; i < cmd.arguments.size(); i++) {
+        const auto& a = cmd.arguments.at(i);
+        if (a == "-c" || depFlag.match(a).hasMatch())
+            continue;
+        if (a == "-o" || (depFile.match(a).hasMatch() && a.size() == 3)) {
+            i++;
+            continue;
+        }
+        if (depFile.match(a).hasMatch())
+            continue;
+        if (!a.startsWith('-') && QDir::cleanPath(dir.absoluteFilePath(a)) == cmd.file)
+            continue;
+        args.append(a);
+    }
+    return args;
+}
+
+QStringList FileCompiler::checkArguments(const CompileCommand &cmd, bool syntaxOnly, bool fromStdin, const QStringList &extraArgs)
+{
+    auto args = baseArguments(cmd);
+    if (syntaxOnly)
+        args << "-fsyntax-only";
+    else
+        args << "-c" << "-o" << QProcess::nullDevice();
+    args << extraArgs;
+    // Quoted includes of a buffer are still looked up next to the real file
+    if (fromStdin)
+        args << "-iquote" << QFileInfo(cmd.file).absolutePath() << "-x" << languageOf(cmd.file) << "-";
+    else
+        args << cmd.file;
+    return args;
+}
@@ -0,0 +1,81 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef FILECOMPILER_H
+#define FILECOMPILER_H
+
+#include <QObject>
+#include <QStringList>
+
+#include <functional>
+#include <memory>
+
+class ProjectManager;
+
+struct CompileCommand {
+    QString directory;
+    QString compiler;
+    QStringList arguments; // Everything after the compiler, the source included
+    QString file;
+
+    bool isValid() const { return !compiler.isEmpty(); }
+};
+
+// Compiles a single translation unit with the command the project uses for
+// it, taken from compile_commands.json or from a make dry run
+class FileCompiler : public QObject
+{
+    Q_OBJECT
+public:
+    using CommandCallback_t = std::function<void (const CompileCommand&)>;
+    using ResultCallback_t = std::function<void (int exitCode, const QByteArray& output)>;
+
+    explicit FileCompiler(ProjectManager *proj, QObject *parent = nullptr);
+    ~FileCompiler() override;
+
+    void commandFor(const QString& path, CommandCallback_t cb);
+    // A null unsaved buffer compiles the file on disk, otherwise the buffer goes through stdin.
+    // Returns a ticket to cancel the compilation, the callback is not called once canceled
+    int compile(const QString& path, const QByteArray& unsaved, bool syntaxOnly, ResultCallback_t cb,
+                const QStringList& extraArgs = QStringList());
+    // Precompiles header with the flags of the translation unit at path
+    int precompile(const QString& path, const QString& header, const QString& output, ResultCallback_t cb);
+    void cancel(int ticket);
+
+    static QStringList tokenize(const QString& line);
+    static CompileCommand fromDatabase(const QByteArray& json, const QString& file);
+    static CompileCommand fromDryRun(const QString& output, const QString& directory, const QString& file);
+    static QString languageOf(const QString& file);
+    // The flags of the command, without the source, the output and dependency generation
+    static QStringList baseArguments(const CompileCommand& cmd);
+    static QStringList checkArguments(const CompileCommand& cmd, bool syntaxOnly, bool fromStdin,
+                                      const QStringList& extraArgs = QStringList());
+
+public slots:
+    void invalidate();
+
+private:
+    void resolve(const QString& file, const CompileCommand& cmd);
+    int run(const QString& path, const QByteArray& input,
+            const std::function<QStringList (const CompileCommand&)>& arguments, ResultCallback_t cb);
+
+    class Priv_t;
+    std::unique_ptr<Priv_t> priv;
+};
+
+#endif // FILECOMPILER_H
@@ -155,6 +155,7 @@ void FileSystemManager::customContextMenu(const QPoint &pos)
     m->addSeparator();
     createAction("debug-execute-from-cursor", tr("Rename"), &FileSystemManager::menuItemRename)->setDisabled(noSelection);
     createAction("document-close", tr("Delete"), &FileSystemManager::menuItemDelete)->setDisabled(noSelection);
+    emit aboutToShowContextMenu(m, info);
     m->exec(view->mapToGlobal(pos));
     m->deleteLater();
 }
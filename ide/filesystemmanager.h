@@ -25,6 +25,7 @@
 #include <memory>
 
 class QTreeView;
+class QMenu;
 
 class FileSystemManager : public QObject
 {
@@ -41,6 +42,7 @@ public:
 
 signals:
     void requestFileOpen(const QString& path);
+    void aboutToShowContextMenu(QMenu *menu, const QFileInfo& info);
 
 public slots:
     void openPath(const QString& path);
@@ -43,7 +43,6 @@ SOURCES += \
     markdowneditor.cpp \
     markdownview.cpp \
     newprojectfromremotedialog.cpp \
-    processlinebufferizer.cpp \
         projectmanager.cpp \
         documentmanager.cpp \
         idocumenteditor.cpp \
@@ -73,8 +72,29 @@ SOURCES += \
     filereferencesdialog.cpp \
     mapfileviewer.cpp \
     textmessagebrocker.cpp \
-    regexhtmltranslator.cpp \
-    imageviewer.cpp
+    imageviewer.cpp \
+    largefileviewer.cpp \
+    documentio.cpp \
+    occurrencehighlighter.cpp \
+    indentdetector.cpp \
+    linediff.cpp \
+    sourceformatter.cpp \
+    projectformatter.cpp \
+    editjournal.cpp \
+    consoleview.cpp \
+    buildoutputparser.cpp \
+    buildproblemsmodel.cpp \
+    buildlogstore.cpp \
+    linesplitter.cpp \
+    ansitexttranslator.cpp \
+    buildtimeline.cpp \
+    buildtimelineview.cpp \
+    jobservergovernor.cpp \
+    compilecache.cpp \
+    filecompiler.cpp \
+    diagnosticmarks.cpp \
+    livediagnostics.cpp \
+    includegraph.cpp
 
 HEADERS += \
     buttoneditoritemdelegate.h \
@@ -85,7 +105,6 @@ HEADERS += \
     markdowneditor.h \
     markdownview.h \
     newprojectfromremotedialog.h \
-    processlinebufferizer.h \
         projectmanager.h \
         documentmanager.h \
         idocumenteditor.h \
@@ -116,8 +135,29 @@ HEADERS += \
     filereferencesdialog.h \
     mapfileviewer.h \
     textmessagebrocker.h \
-    regexhtmltranslator.h \
-    imageviewer.h
+    imageviewer.h \
+    largefileviewer.h \
+    documentio.h \
+    occurrencehighlighter.h \
+    indentdetector.h \
+    linediff.h \
+    sourceformatter.h \
+    projectformatter.h \
+    editjournal.h \
+    consoleview.h \
+    buildoutputparser.h \
+    buildproblemsmodel.h \
+    buildlogstore.h \
+    linesplitter.h \
+    ansitexttranslator.h \
+    buildtimeline.h \
+    buildtimelineview.h \
+    jobservergovernor.h \
+    compilecache.h \
+    filecompiler.h \
+    diagnosticmarks.h \
+    livediagnostics.h \
+    includegraph.h
 
 FORMS += \
     envinputdialog.ui \
@@ -17,6 +17,7 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 #include "idocumenteditor.h"
+#include "documentio.h"
 
 #include <QFile>
 #include <QFileInfo>
@@ -49,11 +50,15 @@ IDocumentEditor *DocumentEditorFactory::create(const QString &path, QWidget *par
         mime = db.mimeTypeForData(QByteArray{"\n"});
     }
 
-    // Try first from suffix
+    // Try first from file properties (size, location...)
+    for(auto c: creators)
+        if (c->canHandleFile(info, mime))
+            return c->create(parent);
+    // Try second from suffix
     for(auto c: creators)
         if (c->canHandleExtentions(suffixes))
             return c->create(parent);
-    // Try second from mimetype
+    // Try third from mimetype
     for(auto c: creators)
         if (c->canHandleMime(mime))
             return c->create(parent);
@@ -63,5 +68,10 @@ IDocumentEditor *DocumentEditorFactory::create(const QString &path, QWidget *par
 IDocumentEditor::~IDocumentEditor()
 = default;
 
+DocumentBuffer IDocumentEditor::snapshot() const
+{
+    return DocumentBuffer();
+}
+
 IDocumentEditorCreator::~IDocumentEditorCreator()
 = default;
@@ -26,10 +26,13 @@
 #include <QString>
 #include <QPoint>
 #include <QMimeType>
+#include <QFileInfo>
+#include <QVariantMap>
 
 #include <functional>
 
 class ICodeModelProvider;
+struct DocumentBuffer;
 
 class IDocumentEditor
 {
@@ -42,6 +45,13 @@ public:
     virtual const QWidget *widget() const = 0;
     virtual QWidget *widget() = 0;
     virtual bool load(const QString& path) = 0;
+    virtual bool canAttach() const { return false; }
+    virtual bool attach(const DocumentBuffer& buffer) { Q_UNUSED(buffer); return false; }
+    virtual bool attachView(IDocumentEditor *source) { Q_UNUSED(source); return false; }
+    virtual bool canSnapshot() const { return false; }
+    virtual DocumentBuffer snapshot() const;
+    // Changes with every edit, a snapshot of the same revision is still current
+    virtual quint64 revision() const { return 0; }
     virtual bool save(const QString& path) = 0;
     virtual void reload() = 0;
     virtual QString path() const { return widget()->windowFilePath(); }
@@ -52,6 +62,8 @@ public:
     virtual void setModified(bool m) = 0;
     virtual QPoint cursor() const = 0;
     virtual void setCursor(const QPoint& pos) = 0;
+    virtual QVariantMap saveState() const { return QVariantMap(); }
+    virtual void restoreState(const QVariantMap& state) { Q_UNUSED(state); }
 
     void setDocumentManager(DocumentManager *man) { this->man = man; }
     DocumentManager *documentManager() const { return this->man; }
@@ -86,6 +98,7 @@ public:
 
     virtual bool canHandleExtentions(const QStringList&) const { return false; }
     virtual bool canHandleMime(const QMimeType&) const { return false; }
+    virtual bool canHandleFile(const QFileInfo&, const QMimeType&) const { return false; }
     virtual IDocumentEditor *create(QWidget *parent = nullptr) const = 0;
 
     template<typename T>
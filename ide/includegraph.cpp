@@ -0,0 +1,271 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "includegraph.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QtConcurrent>
+
+#include <algorithm>
+
+static bool isBlank(const char *p, const char *end)
+{
+    return p == end || *p == ' ' || *p == '\t' || *p == '\r' || *p == '\n';
+}
+
+QVector<IncludeGraph::Rule> IncludeGraph::parse(const QByteArray &data)
+{
+    QVector<Rule> rules;
+    QVector<QByteArray> targets;
+    Rule rule;
+    QByteArray word;
+    bool inTargets = true;
+    auto endWord = [&]() {
+        if (!word.isEmpty())
+            (inTargets? targets : rule.prerequisites).append(word);
+        word.clear();
+    };
+    auto endRule = [&]() {
+        endWord();
+        // Phony rules from -MP have no prerequisites
+        if (!targets.isEmpty() && !rule.prerequisites.isEmpty()) {
+            rule.target = targets.first();
+            rules.append(rule);
+        }
+        targets.clear();
+        rule = Rule{};
+        inTargets = true;
+    };
+
+    const char *p = data.constData();
+    const char *end = p + data.size();
+    while (p < end) {
+        char c = *p++;
+        switch (c) {
+        case '\\':
+            if (p < end && *p == '\n') {
+                p++;
+                endWord();
+            } else if (p + 1 < end && p[0] == '\r' && p[1] == '\n') {
+                p += 2;
+                endWord();
+            } else if (p < end && (*p == ' ' || *p == '#')) {
+                word += *p++;
+            } else {
+                word += c; // Windows separator
+            }
+            break;
+        case '$':
+            if (p < end && *p == '$')
+                p++;
+            word += c;
+            break;
+        case '#':
+            while (p < end && *p != '\n')
+                p++;
+            break;
+        case '\n':
+            endRule();
+            break;
+        case ' ':
+        case '\t':
+        case '\r':
+            endWord();
+            break;
+        case ':':
+            // Not a drive letter
+            if (inTargets && isBlank(p, end)) {
+                endWord();
+                inTargets = false;
+                break;
+            }
+            word += c;
+            break;
+        default:
+            word += c;
+            break;
+        }
+    }
+    endRule();
+    return rules;
+}
+
+struct ParsedDepFile {
+    QString path;
+    QDateTime stamp;
+    QVector<IncludeGraph::Rule> rules;
+};
+
+static ParsedDepFile parseDepFile(const QPair<QString, QDateTime>& f)
+{
+    QFile file(f.first);
+    if (!file.open(QFile::ReadOnly))
+        return { f.first, f.second, {} };
+    return { f.first, f.second, IncludeGraph::parse(file.readAll()) };
+}
+
+int IncludeGraph::refresh(const QString &root)
+{
+    QHash<QString, QDateTime> found;
+    QDirIterator it(root, { "*.d" }, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        found.insert(it.filePath(), it.fileInfo().lastModified());
+    }
+
+    QVector<QPair<QString, QDateTime>> changed;
+    QStringList removed;
+    {
+        QReadLocker locker(&lock);
+        for (auto i = found.cbegin(); i != found.cend(); ++i) {
+            auto d = depFiles.constFind(i.key());
+            if (d == depFiles.cend() || d->stamp != i.value())
+                changed.append({ i.key(), i.value() });
+        }
+        for (auto i = depFiles.cbegin(); i != depFiles.cend(); ++i)
+            if (!found.contains(i.key()))
+                removed.append(i.key());
+    }
+    if (changed.isEmpty() && removed.isEmpty())
+        return 0;
+
+    // Parsing is done without the lock, only the merge blocks the readers
+    auto parsed = QtConcurrent::blockingMapped<QVector<ParsedDepFile>>(changed, parseDepFile);
+    QWriteLocker locker(&lock);
+    for (const auto& path: removed)
+        drop(path);
+    for (const auto& f: parsed) {
+        drop(f.path);
+        add(f.path, f.stamp, f.rules, root);
+    }
+    return changed.size() + removed.size();
+}
+
+void IncludeGraph::clear()
+{
+    QWriteLocker locker(&lock);
+    paths.clear();
+    ids.clear();
+    rawIds.clear();
+    depFiles.clear();
+    units.clear();
+    includers.clear();
+}
+
+bool IncludeGraph::isEmpty() const
+{
+    QReadLocker locker(&lock);
+    return units.isEmpty();
+}
+
+QStringList IncludeGraph::includersOf(const QString &header) const
+{
+    QReadLocker locker(&lock);
+    QSet<int> sources;
+    for (auto object: includers.value(idOf(header)))
+        sources.insert(units.value(object).source);
+    QStringList list;
+    for (auto id: sources)
+        list.append(paths.at(id));
+    std::sort(list.begin(), list.end());
+    return list;
+}
+
+QStringList IncludeGraph::headersOf(const QString &source) const
+{
+    QReadLocker locker(&lock);
+    auto id = idOf(source);
+    QSet<int> headers;
+    if (id != -1) {
+        for (const auto& u: units)
+            if (u.source == id)
+                for (auto h: u.headers)
+                    headers.insert(h);
+    }
+    QStringList list;
+    for (auto h: headers)
+        list.append(paths.at(h));
+    std::sort(list.begin(), list.end());
+    return list;
+}
+
+int IncludeGraph::rebuildImpact(const QString &header) const
+{
+    QReadLocker locker(&lock);
+    return includers.value(idOf(header)).size();
+}
+
+int IncludeGraph::intern(const QByteArray &raw, const QString &root)
+{
+    auto r = rawIds.constFind(raw);
+    if (r != rawIds.cend())
+        return r.value();
+    auto path = QDir::cleanPath(QDir(root).absoluteFilePath(QString::fromLocal8Bit(raw)));
+    auto id = ids.value(path, -1);
+    if (id == -1) {
+        id = paths.size();
+        paths.append(path);
+        ids.insert(path, id);
+    }
+    rawIds.insert(raw, id);
+    return id;
+}
+
+int IncludeGraph::idOf(const QString &path) const
+{
+    return ids.value(QDir::cleanPath(QFileInfo(path).absoluteFilePath()), -1);
+}
+
+void IncludeGraph::drop(const QString &depFile)
+{
+    auto d = depFiles.find(depFile);
+    if (d == depFiles.end())
+        return;
+    for (auto object: d->objects) {
+        for (auto h: units.take(object).headers) {
+            auto i = includers.find(h);
+            if (i != includers.end()) {
+                i->remove(object);
+                if (i->isEmpty())
+                    includers.erase(i);
+            }
+        }
+    }
+    depFiles.erase(d);
+}
+
+void IncludeGraph::add(const QString &depFile, const QDateTime &stamp, const QVector<Rule> &rules, const QString &root)
+{
+    DepFile d{ stamp, {} };
+    for (const auto& rule: rules) {
+        auto object = intern(rule.target, root);
+        Unit u;
+        u.source = intern(rule.prerequisites.first(), root);
+        u.headers.reserve(rule.prerequisites.size() - 1);
+        for (int i = 1; i < rule.prerequisites.size(); i++) {
+            auto h = intern(rule.prerequisites.at(i), root);
+            u.headers.append(h);
+            includers[h].insert(object);
+        }
+        units.insert(object, u);
+        d.objects.append(object);
+    }
+    depFiles.insert(depFile, d);
+}
@@ -0,0 +1,75 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef INCLUDEGRAPH_H
+#define INCLUDEGRAPH_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QReadWriteLock>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+// Header dependencies of the project as written by the compiler in -MD/-MMD .d files
+class IncludeGraph
+{
+public:
+    struct Rule {
+        QByteArray target;
+        QVector<QByteArray> prerequisites;
+    };
+
+    static QVector<Rule> parse(const QByteArray& data);
+
+    // Rereads the .d files below root changed since the last call and drops
+    // the removed ones. Relative paths are taken from root. Thread safe.
+    int refresh(const QString& root);
+    void clear();
+
+    bool isEmpty() const;
+    QStringList includersOf(const QString& header) const;
+    QStringList headersOf(const QString& source) const;
+    int rebuildImpact(const QString& header) const;
+
+private:
+    struct Unit {
+        int source = -1;
+        QVector<int> headers;
+    };
+    struct DepFile {
+        QDateTime stamp;
+        QVector<int> objects;
+    };
+
+    int intern(const QByteArray& raw, const QString& root);
+    int idOf(const QString& path) const;
+    void drop(const QString& depFile);
+    void add(const QString& depFile, const QDateTime& stamp, const QVector<Rule>& rules, const QString& root);
+
+    mutable QReadWriteLock lock;
+    QVector<QString> paths;
+    QHash<QString, int> ids;
+    QHash<QByteArray, int> rawIds;
+    QHash<QString, DepFile> depFiles;
+    QHash<int, Unit> units; // By object
+    QHash<int, QSet<int>> includers; // Header to objects
+};
+
+#endif // INCLUDEGRAPH_H
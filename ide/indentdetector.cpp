@@ -0,0 +1,151 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "indentdetector.h"
+
+#include <array>
+#include <cstring>
+
+// NPP detect indent from nppIndenture writed by Evan King
+// https://github.com/evan-king/nppIndenture
+// Licenced by GPL-3.0
+// Adapted to run over the raw file bytes before the editor get the text
+
+constexpr auto MIN_INDENT = 2; // minimum width of a single indentation
+constexpr auto MAX_INDENT = 8; // maximum width of a single indentation
+
+constexpr auto MIN_DEPTH = MIN_INDENT; // ignore lines below this indentation level
+constexpr auto MAX_DEPTH = 3*MAX_INDENT; // ignore lines beyond this indentation level
+
+// % of lines allowed to contradict indentation option without penalty
+constexpr auto GRACE_FREQUENCY = 1 / 50.0F;
+
+// Statistics are checked each CHECK_INTERVAL indented lines and the scan stop
+// when the decision is the same for STABLE_CHECKS times in a row
+constexpr auto CHECK_INTERVAL = 256;
+constexpr auto STABLE_CHECKS = 4;
+
+namespace {
+
+struct ParseResult {
+    int num_lines = 0;
+    int num_tab_lines = 0;
+    int num_space_lines = 0;
+
+    // indentation => count(lines of that exact indentation)
+    std::array<int, MAX_DEPTH+1> depth_counts = { { 0 } };
+};
+
+IndentInfo decide(const ParseResult& result)
+{
+    IndentInfo info;
+    const float grace = float(result.num_lines) * GRACE_FREQUENCY;
+
+    // decide `type`
+    if(result.num_tab_lines + result.num_space_lines == 0)
+        info.type = IndentInfo::IndentType::Invalid;
+    else if(result.num_space_lines > (result.num_tab_lines * 4))
+        info.type = IndentInfo::IndentType::Space;
+    else if(result.num_tab_lines > (result.num_space_lines * 4))
+        info.type = IndentInfo::IndentType::Tab;
+
+    // decide `num`
+    if(info.type == IndentInfo::IndentType::Space) {
+
+        // indent size => count(space-indented lines with incompatible indentation)
+        std::array<int, MAX_INDENT+1> margins = {0};
+        using margins_size = decltype (margins)::size_type;
+
+        // for each depth option, count the incompatible lines
+        for(margins_size i = MIN_DEPTH; i <= MAX_DEPTH; i++) {
+            for(margins_size k = MIN_INDENT; k <= MAX_INDENT; k++) {
+                if(i % k == 0)
+                    continue;
+                margins.at(k) += result.depth_counts.at(i);
+            }
+        }
+
+        // choose the last indent with the smallest margin (ties go to larger indent)
+        // Considers margins within grace of zero as =zero,
+        // so occasional typos don't force smaller indentation
+        margins_size which = MIN_INDENT;
+        for(margins_size i = MIN_INDENT; i <= MAX_INDENT; ++i) {
+            if(result.depth_counts.at(i) == 0) continue;
+            if(margins.at(i) <= margins.at(which) || margins.at(i) < grace) which = i;
+        }
+
+        info.num = static_cast<int>(which);
+    }
+
+    return info;
+}
+
+}
+
+IndentInfo IndentDetector::detect(const QByteArray &text, int tabWidth)
+{
+    tabWidth = qMax(1, tabWidth);
+    ParseResult result;
+    IndentInfo last;
+    int stable = 0;
+    int indented = 0;
+
+    const char *p = text.constData();
+    const char *end = p + text.size();
+    while (p < end) {
+        result.num_lines++;
+        const char head = *p;
+        int depth = 0;
+        const char *q = p;
+        for(; q < end; ++q) {
+            if (*q == ' ')
+                depth++;
+            else if (*q == '\t')
+                depth += tabWidth - (depth % tabWidth);
+            else
+                break;
+        }
+        // Jump to the next line, memchr is vectorized by the C library
+        auto nl = static_cast<const char*>(std::memchr(q, '\n', static_cast<size_t>(end - q)));
+        const bool blank = q == end || *q == '\n' || *q == '\r';
+        p = nl? nl + 1 : end;
+
+        if(blank || depth < MIN_DEPTH || depth > MAX_DEPTH)
+            continue;
+
+        if(head == '\t') result.num_tab_lines++;
+
+        if(head == ' ') {
+            result.num_space_lines++;
+            result.depth_counts.at(static_cast<size_t>(depth))++;
+        }
+
+        if (++indented % CHECK_INTERVAL == 0) {
+            auto info = decide(result);
+            if (info.type != IndentInfo::IndentType::Invalid &&
+                    info.type == last.type && info.num == last.num) {
+                if (++stable >= STABLE_CHECKS)
+                    return info;
+            } else
+                stable = 0;
+            last = info;
+        }
+    }
+
+    return decide(result);
+}
@@ -0,0 +1,38 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef INDENTDETECTOR_H
+#define INDENTDETECTOR_H
+
+#include <QByteArray>
+
+struct IndentInfo {
+    enum class IndentType { Invalid, Space, Tab };
+
+    IndentType type = IndentType::Invalid;
+    int num = 0;
+};
+
+class IndentDetector
+{
+public:
+    // The tab width only measures the depth of tab indented lines
+    static IndentInfo detect(const QByteArray& text, int tabWidth);
+};
+
+#endif // INDENTDETECTOR_H
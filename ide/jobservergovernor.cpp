@@ -0,0 +1,243 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "jobservergovernor.h"
+
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QThread>
+#include <QtConcurrent>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+static constexpr int REGULATE_INTERVAL = 500;
+static constexpr qint64 MEMORY_RESERVE_KB = 512 * 1024;
+static constexpr qint64 INITIAL_JOB_RSS_KB = 256 * 1024;
+
+#ifdef Q_OS_LINUX
+static qint64 availableMemoryKb()
+{
+    QFile f("/proc/meminfo");
+    if (!f.open(QFile::ReadOnly))
+        return -1;
+    while (!f.atEnd()) {
+        auto line = f.readLine();
+        if (line.startsWith("MemAvailable:"))
+            return line.mid(13).trimmed().split(' ').first().toLongLong();
+    }
+    return -1;
+}
+
+// Parent to children map of all the processes, one /proc scan
+static QHash<qint64, QVector<qint64>> processTree()
+{
+    QHash<qint64, QVector<qint64>> children;
+    for (const auto& entry: QDir("/proc").entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        bool ok;
+        auto p = entry.toLongLong(&ok);
+        if (!ok)
+            continue;
+        QFile stat(QString("/proc/%1/stat").arg(p));
+        if (!stat.open(QFile::ReadOnly))
+            continue;
+        auto data = stat.readAll();
+        auto fields = data.mid(data.lastIndexOf(')') + 2).split(' ');
+        if (fields.size() > 1)
+            children[fields.at(1).toLongLong()].append(p);
+    }
+    return children;
+}
+
+// Resident memory of every process below pid and how many of them are
+// recipe shells or compilers, counted as the processes without children
+static qint64 descendantRssKb(const QHash<qint64, QVector<qint64>>& children, qint64 pid, int *leaves)
+{
+    static const qint64 pageKb = sysconf(_SC_PAGESIZE) / 1024;
+    qint64 rss = 0;
+    QVector<qint64> pending = children.value(pid);
+    while (!pending.isEmpty()) {
+        auto p = pending.takeLast();
+        QFile statm(QString("/proc/%1/statm").arg(p));
+        if (statm.open(QFile::ReadOnly)) {
+            auto fields = statm.readAll().split(' ');
+            if (fields.size() > 1)
+                rss += fields.at(1).toLongLong() * pageKb;
+        }
+        auto sub = children.value(p);
+        if (sub.isEmpty())
+            (*leaves)++;
+        pending += sub;
+    }
+    return rss;
+}
+#endif
+
+JobServerGovernor::JobServerGovernor(QObject *parent) : QObject(parent)
+{
+    timer.setInterval(REGULATE_INTERVAL);
+    connect(&timer, &QTimer::timeout, this, &JobServerGovernor::sample);
+    connect(&sampler, &QFutureWatcher<MemorySample>::finished, this, &JobServerGovernor::regulate);
+}
+
+JobServerGovernor::~JobServerGovernor()
+{
+    stop();
+}
+
+bool JobServerGovernor::isSupported()
+{
+#ifdef Q_OS_LINUX
+    return true;
+#else
+    return false;
+#endif
+}
+
+QString JobServerGovernor::start(int jobs)
+{
+    stop();
+#ifdef Q_OS_LINUX
+    int fds[2];
+    if (::pipe2(fds, O_CLOEXEC) != 0)
+        return QString();
+    readFd = fds[0];
+    writeFd = fds[1];
+    // Reopened through /proc to get a non blocking read without touching make's side
+    drainFd = ::open(QString("/proc/self/fd/%1").arg(readFd).toLocal8Bit().constData(),
+                     O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (drainFd < 0) {
+        stop();
+        return QString();
+    }
+    maxJobs = qMax(1, jobs);
+    jobRss = INITIAL_JOB_RSS_KB;
+    tokens = 0;
+    makePids.clear();
+    // Start conservative, the first regulation opens up as memory allows
+    setTokens(qMin(maxJobs - 1, QThread::idealThreadCount() / 2));
+    return QString("-j --jobserver-auth=%1,%2").arg(readFd).arg(writeFd);
+#else
+    Q_UNUSED(jobs)
+    return QString();
+#endif
+}
+
+void JobServerGovernor::setInheritable(bool inheritable)
+{
+#ifdef Q_OS_LINUX
+    for (auto fd: { readFd, writeFd })
+        if (fd >= 0)
+            ::fcntl(fd, F_SETFD, inheritable? 0 : FD_CLOEXEC);
+#else
+    Q_UNUSED(inheritable)
+#endif
+}
+
+void JobServerGovernor::attach(qint64 pid)
+{
+    makePids.insert(pid);
+    if (!timer.isActive())
+        timer.start();
+}
+
+void JobServerGovernor::detach(qint64 pid)
+{
+    makePids.remove(pid);
+}
+
+void JobServerGovernor::stop()
+{
+    timer.stop();
+#ifdef Q_OS_LINUX
+    for (auto fd: { &readFd, &writeFd, &drainFd }) {
+        if (*fd >= 0)
+            ::close(*fd);
+        *fd = -1;
+    }
+#endif
+    tokens = 0;
+    makePids.clear();
+}
+
+JobServerGovernor::MemorySample JobServerGovernor::measure(const QSet<qint64> &pids)
+{
+    MemorySample s;
+#ifdef Q_OS_LINUX
+    auto children = processTree();
+    for (auto pid: pids)
+        s.rss += descendantRssKb(children, pid, &s.leaves);
+    s.available = availableMemoryKb();
+#else
+    Q_UNUSED(pids)
+#endif
+    return s;
+}
+
+void JobServerGovernor::sample()
+{
+    // Scanning /proc takes a while with many processes, it runs off the GUI thread
+    if (makePids.isEmpty() || sampler.isRunning())
+        return;
+    sampler.setFuture(QtConcurrent::run(&JobServerGovernor::measure, makePids));
+}
+
+void JobServerGovernor::regulate()
+{
+#ifdef Q_OS_LINUX
+    if (makePids.isEmpty() || drainFd < 0)
+        return;
+    auto s = sampler.result();
+    int idle = 0;
+    ::ioctl(drainFd, FIONREAD, &idle);
+    // Every make runs one job on its implicit token
+    int running = qMax(1, tokens - idle + makePids.size());
+    if (s.leaves > 0) {
+        // Peaks matter, a link grows long after it starts: rise fast, decay slow
+        double perJob = double(s.rss) / qMax(running, s.leaves);
+        jobRss = perJob > jobRss? perJob : jobRss * 0.9 + perJob * 0.1;
+    }
+    if (s.available < 0)
+        return;
+    int fits = int((s.available - MEMORY_RESERVE_KB) / qMax(1.0, jobRss));
+    int target = qBound(makePids.size(), running + fits, maxJobs);
+    setTokens(target - makePids.size());
+#endif
+}
+
+void JobServerGovernor::setTokens(int count)
+{
+#ifdef Q_OS_LINUX
+    count = qMax(0, count);
+    while (tokens < count) {
+        if (::write(writeFd, "+", 1) != 1)
+            break;
+        tokens++;
+    }
+    // Only idle tokens can be taken back, running jobs finish undisturbed
+    char c;
+    while (tokens > count && ::read(drainFd, &c, 1) == 1)
+        tokens--;
+#else
+    Q_UNUSED(count)
+#endif
+}
@@ -0,0 +1,74 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef JOBSERVERGOVERNOR_H
+#define JOBSERVERGOVERNOR_H
+
+#include <QFutureWatcher>
+#include <QObject>
+#include <QSet>
+#include <QTimer>
+
+// Runs the GNU make jobserver for the builds and hands out job tokens as long
+// as the free memory holds the observed footprint of one more job
+class JobServerGovernor : public QObject
+{
+    Q_OBJECT
+public:
+    explicit JobServerGovernor(QObject *parent = nullptr);
+    ~JobServerGovernor() override;
+
+    static bool isSupported();
+
+    // Returns the MAKEFLAGS value for the top level makes or an empty string
+    QString start(int maxJobs);
+    bool isRunning() const { return writeFd >= 0; }
+    // The descriptors are only inherited while a make is being started
+    void setInheritable(bool inheritable);
+    void attach(qint64 makePid);
+    void detach(qint64 makePid);
+    void stop();
+
+    int currentJobs() const { return tokens + 1; }
+
+private slots:
+    void sample();
+    void regulate();
+
+private:
+    struct MemorySample {
+        qint64 rss = 0;        // Kilobytes below all the makes
+        int leaves = 0;        // Recipe shells or compilers
+        qint64 available = -1; // Kilobytes
+    };
+
+    static MemorySample measure(const QSet<qint64>& pids);
+    void setTokens(int count);
+
+    QTimer timer;
+    QFutureWatcher<MemorySample> sampler;
+    int readFd = -1;
+    int writeFd = -1;
+    int drainFd = -1; // Own non blocking description of the read end
+    int maxJobs = 1;
+    int tokens = 0;   // Handed to make, in the pipe or held by running jobs
+    QSet<qint64> makePids;
+    double jobRss = 0.0; // Kilobytes, running estimate of one job footprint
+};
+
+#endif // JOBSERVERGOVERNOR_H
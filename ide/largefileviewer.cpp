@@ -0,0 +1,503 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "largefileviewer.h"
+#include "appconfig.h"
+#include "findlineedit.h"
+
+#include <QApplication>
+#include <QClipboard>
+#include <QFileInfo>
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QMimeType>
+#include <QPainter>
+#include <QScrollBar>
+#include <QShortcut>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <functional>
+#include <cstring>
+
+static const qint64 INDEX_CHUNK_SIZE = 16 * 1024 * 1024;
+static const int MAX_DISPLAY_LINE = 4096;
+static const int GUTTER_PADDING = 8;
+static const qint64 SEARCH_BLOCK_SIZE = 4 * 1024 * 1024; // Cancellation is checked between blocks
+
+static inline uchar toLowerAscii(uchar c)
+{
+    return (c >= 'A' && c <= 'Z')? c + ('a' - 'A') : c;
+}
+
+static inline uchar otherCaseAscii(uchar c)
+{
+    return ((c | 0x20) >= 'a' && (c | 0x20) <= 'z')? c ^ 0x20 : c;
+}
+
+// First match starting in [begin, end - n]
+static qint64 searchForward(const uchar *data, qint64 begin, qint64 end, const QByteArray& needle, bool cs)
+{
+    const auto n = qint64(needle.size());
+    const auto pattern = reinterpret_cast<const uchar*>(needle.constData());
+    if (n == 0 || end - begin < n)
+        return -1;
+    auto matchAt = [pattern, n, cs](const uchar *p) {
+        if (cs)
+            return std::memcmp(p, pattern, size_t(n)) == 0;
+        for(qint64 k = 0; k < n; k++)
+            if (toLowerAscii(p[k]) != toLowerAscii(pattern[k]))
+                return false;
+        return true;
+    };
+    // memchr is vectorized by the C library, it skips to the candidates of both cases
+    const auto last = data + end - n;
+    auto next = [last](const uchar *p, uchar c) {
+        return p > last? nullptr : static_cast<const uchar*>(std::memchr(p, c, size_t(last - p + 1)));
+    };
+    const uchar first = pattern[0];
+    const uchar other = cs? first : otherCaseAscii(first);
+    auto pa = next(data + begin, first);
+    auto pb = other != first? next(data + begin, other) : nullptr;
+    while (pa || pb) {
+        bool useA = pa && (!pb || pa < pb);
+        auto p = useA? pa : pb;
+        if (matchAt(p))
+            return p - data;
+        if (useA)
+            pa = next(pa + 1, first);
+        else
+            pb = next(pb + 1, other);
+    }
+    return -1;
+}
+
+static qint64 searchBlocks(const uchar *data, qint64 begin, qint64 end, const QByteArray& needle, bool cs,
+                           bool forward, const std::function<bool ()>& canceled)
+{
+    const auto n = qint64(needle.size());
+    if (forward) {
+        for(qint64 lo = begin; end - lo >= n && !canceled(); lo += SEARCH_BLOCK_SIZE) {
+            auto hit = searchForward(data, lo, qMin(end, lo + SEARCH_BLOCK_SIZE + n - 1), needle, cs);
+            if (hit != -1)
+                return hit;
+        }
+    } else {
+        // The last match of each block, walking the blocks from the end
+        for(qint64 hi = end; hi - begin >= n && !canceled(); hi -= SEARCH_BLOCK_SIZE) {
+            auto lo = qMax(begin, hi - SEARCH_BLOCK_SIZE - n + 1);
+            qint64 found = -1;
+            for(auto p = searchForward(data, lo, hi, needle, cs); p != -1; p = searchForward(data, p + 1, hi, needle, cs))
+                found = p;
+            if (found != -1)
+                return found;
+        }
+    }
+    return -1;
+}
+
+LargeFileViewer::LargeFileViewer(QWidget *parent) :
+    QAbstractScrollArea(parent),
+    findEdit(new FindLineEdit(this))
+{
+    setFont(AppConfig::instance().editorFont());
+    connect(&AppConfig::instance(), &AppConfig::configChanged, [this]() {
+        setFont(AppConfig::instance().editorFont());
+        updateScrollBars();
+        viewport()->update();
+    });
+    viewport()->setCursor(Qt::IBeamCursor);
+    setFocusPolicy(Qt::StrongFocus);
+
+    findEdit->setPlaceholderText(tr("Find in file"));
+    findEdit->addMenuActions({ { tr("Case sensitive"), "caseSensitive" } });
+    findEdit->hide();
+    connect(findEdit, &QLineEdit::returnPressed, this, &LargeFileViewer::findNext);
+    connect(findEdit, &QLineEdit::textChanged, [this]() {
+        searchGeneration.ref();
+        matchOffset = -1;
+        viewport()->update();
+    });
+    auto escape = new QShortcut(QKeySequence(Qt::Key_Escape), this);
+    escape->setContext(Qt::WidgetWithChildrenShortcut);
+    connect(escape, &QShortcut::activated, [this]() {
+        findEdit->hide();
+        setFocus();
+    });
+
+    connect(&indexWatcher, &QFutureWatcher<IndexChunk>::finished, [this]() {
+        if (!indexWatcher.future().isFinished())
+            return;
+        auto chunk = indexWatcher.result();
+        if (chunk.generation == indexGeneration)
+            appendIndexChunk(chunk);
+    });
+    connect(&searchWatcher, &QFutureWatcher<SearchResult>::finished, [this]() {
+        if (!searchWatcher.future().isFinished())
+            return;
+        auto r = searchWatcher.result();
+        if (r.generation == searchGeneration.load() && r.hit != -1)
+            showMatch(r.hit, r.length);
+    });
+}
+
+LargeFileViewer::~LargeFileViewer()
+{
+    unmap();
+}
+
+bool LargeFileViewer::load(const QString &path)
+{
+    unmap();
+    file.setFileName(path);
+    if (!file.open(QFile::ReadOnly))
+        return false;
+    mappedSize = file.size();
+    mapped = mappedSize > 0? file.map(0, mappedSize) : nullptr;
+    if (mappedSize > 0 && !mapped) {
+        file.close();
+        mappedSize = 0;
+        return false;
+    }
+    setPath(path);
+    lineStarts.append(0);
+    scheduleIndexChunk();
+    updateScrollBars();
+    viewport()->update();
+    return true;
+}
+
+void LargeFileViewer::reload()
+{
+    auto line = currentLine;
+    if (load(path()))
+        setCurrentLine(line, true);
+}
+
+QPoint LargeFileViewer::cursor() const
+{
+    return { 0, currentLine };
+}
+
+void LargeFileViewer::setCursor(const QPoint &pos)
+{
+    setCurrentLine(pos.y() - 1, true);
+}
+
+void LargeFileViewer::findNext()
+{
+    if (!mapped)
+        return;
+    startSearch(matchOffset >= 0? matchOffset + 1 : lineStarts.value(currentLine, 0), true);
+}
+
+void LargeFileViewer::findPrevious()
+{
+    if (!mapped)
+        return;
+    startSearch(matchOffset >= 0? matchOffset : lineStarts.value(currentLine, 0), false);
+}
+
+void LargeFileViewer::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+    QPainter p(viewport());
+    const auto& pal = palette();
+    const auto fm = fontMetrics();
+    const int lh = fm.height();
+    const int cw = fm.averageCharWidth();
+    const int gutter = fm.averageCharWidth() * QString::number(lineCount()).length() + GUTTER_PADDING * 2;
+    const int xoff = gutter - horizontalScrollBar()->value() * cw;
+    const int first = verticalScrollBar()->value();
+    const int rows = viewport()->height() / lh + 1;
+
+    p.fillRect(viewport()->rect(), pal.base());
+    p.fillRect(QRect(0, 0, gutter, viewport()->height()), pal.alternateBase());
+    for(int r = 0; r < rows; r++) {
+        int line = first + r;
+        if (line >= lineCount())
+            break;
+        int y = r * lh;
+        auto bytes = lineBytes(line);
+        if (line == currentLine)
+            p.fillRect(QRect(gutter, y, viewport()->width() - gutter, lh), pal.alternateBase());
+        auto start = lineStarts.at(line);
+        if (matchOffset >= start && matchOffset < start + bytes.size()) {
+            auto col = expandTabs(bytes.left(int(matchOffset - start))).length();
+            auto len = expandTabs(bytes.mid(int(matchOffset - start), matchLength)).length();
+            p.fillRect(QRect(xoff + col * cw, y, len * cw, lh), pal.highlight());
+        }
+        p.setClipRect(gutter, 0, viewport()->width() - gutter, viewport()->height());
+        p.setPen(pal.text().color());
+        p.drawText(xoff, y + fm.ascent(), expandTabs(bytes));
+        p.setClipping(false);
+        p.setPen(pal.color(QPalette::Disabled, QPalette::Text));
+        p.drawText(QRect(0, y, gutter - GUTTER_PADDING, lh), Qt::AlignRight | Qt::AlignVCenter, QString::number(line + 1));
+    }
+}
+
+void LargeFileViewer::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    auto vp = viewport()->geometry();
+    auto w = qMin(vp.width() / 2, findEdit->sizeHint().width() * 2);
+    findEdit->setGeometry(vp.right() - w - GUTTER_PADDING, vp.top() + GUTTER_PADDING, w, findEdit->sizeHint().height());
+    updateScrollBars();
+}
+
+void LargeFileViewer::keyPressEvent(QKeyEvent *event)
+{
+    const int page = qMax(1, viewport()->height() / fontMetrics().height() - 1);
+    if (event->matches(QKeySequence::Find)) {
+        findEdit->show();
+        findEdit->setFocus();
+        findEdit->selectAll();
+    } else if (event->matches(QKeySequence::FindNext)) {
+        findNext();
+    } else if (event->matches(QKeySequence::FindPrevious)) {
+        findPrevious();
+    } else if (event->matches(QKeySequence::Copy)) {
+        QApplication::clipboard()->setText(QString::fromUtf8(lineBytes(currentLine)));
+    } else if (event->matches(QKeySequence::MoveToPreviousLine)) {
+        setCurrentLine(currentLine - 1);
+    } else if (event->matches(QKeySequence::MoveToNextLine)) {
+        setCurrentLine(currentLine + 1);
+    } else if (event->matches(QKeySequence::MoveToPreviousPage)) {
+        setCurrentLine(currentLine - page);
+    } else if (event->matches(QKeySequence::MoveToNextPage)) {
+        setCurrentLine(currentLine + page);
+    } else if (event->matches(QKeySequence::MoveToStartOfDocument)) {
+        setCurrentLine(0);
+    } else if (event->matches(QKeySequence::MoveToEndOfDocument)) {
+        setCurrentLine(lineCount() - 1);
+    } else
+        QAbstractScrollArea::keyPressEvent(event);
+}
+
+void LargeFileViewer::mousePressEvent(QMouseEvent *event)
+{
+    setCurrentLine(verticalScrollBar()->value() + event->pos().y() / fontMetrics().height());
+    QAbstractScrollArea::mousePressEvent(event);
+}
+
+void LargeFileViewer::unmap()
+{
+    // The indexer and the search read the mapping, wait for them before release
+    indexGeneration++;
+    indexWatcher.waitForFinished();
+    searchGeneration.ref();
+    searchWatcher.waitForFinished();
+    if (mapped)
+        file.unmap(const_cast<uchar*>(mapped));
+    file.close();
+    mapped = nullptr;
+    mappedSize = 0;
+    lineStarts.clear();
+    indexedBytes = 0;
+    longestLine = 0;
+    currentLine = 0;
+    matchOffset = -1;
+    pendingReveal = false;
+}
+
+void LargeFileViewer::scheduleIndexChunk()
+{
+    auto base = mapped;
+    auto from = indexedBytes;
+    auto to = qMin(mappedSize, indexedBytes + INDEX_CHUNK_SIZE);
+    auto lastStart = lineStarts.last();
+    auto generation = indexGeneration;
+    indexWatcher.setFuture(QtConcurrent::run([base, from, to, lastStart, generation]() {
+        IndexChunk chunk;
+        chunk.generation = generation;
+        chunk.end = to;
+        auto prev = lastStart;
+        auto p = base + from;
+        auto end = base + to;
+        while (p < end) {
+            auto nl = static_cast<const uchar*>(std::memchr(p, '\n', size_t(end - p)));
+            if (!nl)
+                break;
+            qint64 next = (nl - base) + 1;
+            chunk.longest = qMax(chunk.longest, next - 1 - prev);
+            chunk.starts.append(next);
+            prev = next;
+            p = nl + 1;
+        }
+        return chunk;
+    }));
+}
+
+void LargeFileViewer::appendIndexChunk(const IndexChunk &chunk)
+{
+    lineStarts += chunk.starts;
+    indexedBytes = chunk.end;
+    longestLine = qMax(longestLine, chunk.longest);
+    if (isIndexComplete())
+        longestLine = qMax(longestLine, mappedSize - lineStarts.last());
+    else
+        scheduleIndexChunk();
+    updateScrollBars();
+    if (pendingReveal && currentLine < lineCount())
+        setCurrentLine(currentLine, true);
+    viewport()->update();
+}
+
+void LargeFileViewer::updateScrollBars()
+{
+    const auto fm = fontMetrics();
+    const int rows = viewport()->height() / fm.height();
+    const int cols = viewport()->width() / qMax(1, fm.averageCharWidth());
+    verticalScrollBar()->setRange(0, qMax(0, lineCount() - rows));
+    verticalScrollBar()->setPageStep(rows);
+    horizontalScrollBar()->setRange(0, int(qMax(qint64(0), qMin(longestLine, qint64(MAX_DISPLAY_LINE)) - cols / 2)));
+    horizontalScrollBar()->setPageStep(cols);
+}
+
+void LargeFileViewer::setCurrentLine(int line, bool center)
+{
+    line = qMax(0, line);
+    if (line >= lineCount() && isIndexComplete())
+        line = lineCount() - 1;
+    currentLine = line;
+    // Lines beyond the index are revealed when the indexer reach them
+    pendingReveal = line >= lineCount();
+    if (!pendingReveal) {
+        const int rows = qMax(1, viewport()->height() / fontMetrics().height());
+        auto first = verticalScrollBar()->value();
+        if (center)
+            verticalScrollBar()->setValue(line - rows / 2);
+        else if (line < first)
+            verticalScrollBar()->setValue(line);
+        else if (line >= first + rows)
+            verticalScrollBar()->setValue(line - rows + 1);
+        notifyCursorOvserver(line + 1, 1);
+    }
+    viewport()->update();
+}
+
+int LargeFileViewer::lineForOffset(qint64 offset) const
+{
+    auto it = std::upper_bound(lineStarts.cbegin(), lineStarts.cend(), offset);
+    int line = int(it - lineStarts.cbegin()) - 1;
+    if (offset >= indexedBytes) {
+        // Not indexed yet, count the remaining newlines directly
+        auto p = mapped + lineStarts.last();
+        auto end = mapped + offset;
+        while (p < end && (p = static_cast<const uchar*>(std::memchr(p, '\n', size_t(end - p)))) != nullptr) {
+            line++;
+            p++;
+        }
+    }
+    return line;
+}
+
+QByteArray LargeFileViewer::lineBytes(int line) const
+{
+    if (!mapped || line < 0 || line >= lineCount())
+        return QByteArray();
+    auto start = lineStarts.at(line);
+    auto p = reinterpret_cast<const char*>(mapped + start);
+    auto avail = int(qMin(mappedSize - start, qint64(MAX_DISPLAY_LINE)));
+    auto nl = static_cast<const char*>(std::memchr(p, '\n', size_t(avail)));
+    int len = nl? int(nl - p) : avail;
+    if (len > 0 && p[len - 1] == '\r')
+        len--;
+    return QByteArray::fromRawData(p, len);
+}
+
+QString LargeFileViewer::expandTabs(const QByteArray &bytes) const
+{
+    const int tabWidth = qMax(1, AppConfig::instance().editorTabWidth());
+    auto text = QString::fromUtf8(bytes);
+    QString out;
+    out.reserve(text.size());
+    for(const auto& c: text) {
+        if (c == '\t')
+            out.append(QString(tabWidth - out.length() % tabWidth, ' '));
+        else
+            out.append(c);
+    }
+    return out;
+}
+
+void LargeFileViewer::startSearch(qint64 from, bool forward)
+{
+    auto needle = findEdit->text().toUtf8();
+    if (needle.isEmpty())
+        return;
+    auto cs = findEdit->isPropertyChecked("caseSensitive");
+    auto data = mapped;
+    auto size = mappedSize;
+    // A newer search or closing the file cancels the running one
+    int generation = searchGeneration.fetchAndAddOrdered(1) + 1;
+    const auto *current = &searchGeneration;
+    searchWatcher.setFuture(QtConcurrent::run([=]() {
+        auto canceled = [current, generation]() { return current->load() != generation; };
+        SearchResult r{ -1, needle.size(), generation };
+        if (forward) {
+            r.hit = searchBlocks(data, from, size, needle, cs, true, canceled);
+            if (r.hit == -1)
+                r.hit = searchBlocks(data, 0, size, needle, cs, true, canceled);
+        } else {
+            r.hit = searchBlocks(data, 0, qMin(size, from + needle.size() - 1), needle, cs, false, canceled);
+            if (r.hit == -1)
+                r.hit = searchBlocks(data, 0, size, needle, cs, false, canceled);
+        }
+        return r;
+    }));
+}
+
+void LargeFileViewer::showMatch(qint64 hit, int length)
+{
+    matchOffset = hit;
+    matchLength = length;
+    auto line = lineForOffset(hit);
+    setCurrentLine(line, true);
+    if (!pendingReveal) {
+        auto bytes = lineBytes(line);
+        auto col = expandTabs(bytes.left(int(hit - lineStarts.at(line)))).length();
+        auto cols = viewport()->width() / qMax(1, fontMetrics().averageCharWidth());
+        auto h = horizontalScrollBar()->value();
+        if (col < h || col >= h + cols - GUTTER_PADDING)
+            horizontalScrollBar()->setValue(col - cols / 2);
+    }
+}
+
+class LargeFileViewerCreator: public IDocumentEditorCreator
+{
+public:
+    ~LargeFileViewerCreator() override;
+
+    bool canHandleFile(const QFileInfo &info, const QMimeType &mime) const override {
+        auto threshold = qint64(AppConfig::instance().editorLargeFileThreshold()) * 1024 * 1024;
+        return threshold > 0 && info.size() >= threshold && mime.inherits("text/plain");
+    }
+
+    IDocumentEditor *create(QWidget *parent = nullptr) const override {
+        return new LargeFileViewer(parent);
+    }
+};
+
+LargeFileViewerCreator::~LargeFileViewerCreator()
+= default;
+
+IDocumentEditorCreator *LargeFileViewer::creator()
+{
+    return IDocumentEditorCreator::staticCreator<LargeFileViewerCreator>();
+}
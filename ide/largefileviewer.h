@@ -0,0 +1,111 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef LARGEFILEVIEWER_H
+#define LARGEFILEVIEWER_H
+
+#include <idocumenteditor.h>
+
+#include <QAbstractScrollArea>
+#include <QAtomicInt>
+#include <QFile>
+#include <QFutureWatcher>
+#include <QVector>
+
+class FindLineEdit;
+
+class LargeFileViewer : public QAbstractScrollArea, public IDocumentEditor
+{
+    Q_OBJECT
+public:
+    explicit LargeFileViewer(QWidget *parent = nullptr);
+    ~LargeFileViewer() override;
+
+    const QWidget *widget() const override { return this; }
+    QWidget *widget() override { return this; }
+    bool load(const QString &path) override;
+    bool save(const QString &path) override { Q_UNUSED(path); return false; }
+    void reload() override;
+    bool isReadonly() const override { return true; }
+    void setReadonly(bool rdOnly) override { Q_UNUSED(rdOnly); }
+    bool isModified() const override { return false; }
+    void setModified(bool m) override { Q_UNUSED(m); }
+    QPoint cursor() const override;
+    void setCursor(const QPoint &pos) override;
+    QVariantMap saveState() const override { return { { "line", currentLine } }; }
+    void restoreState(const QVariantMap& state) override { setCurrentLine(state.value("line").toInt(), true); }
+
+    int lineCount() const { return lineStarts.count(); }
+    bool isIndexComplete() const { return indexedBytes >= mappedSize; }
+
+    static IDocumentEditorCreator *creator();
+
+public slots:
+    void findNext();
+    void findPrevious();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+
+private:
+    struct IndexChunk {
+        QVector<qint64> starts;
+        qint64 end = 0;
+        qint64 longest = 0;
+        int generation = 0;
+    };
+    struct SearchResult {
+        qint64 hit;
+        int length;
+        int generation;
+    };
+
+    void unmap();
+    void scheduleIndexChunk();
+    void appendIndexChunk(const IndexChunk& chunk);
+    void updateScrollBars();
+    void setCurrentLine(int line, bool center = false);
+    int lineForOffset(qint64 offset) const;
+    QByteArray lineBytes(int line) const;
+    QString expandTabs(const QByteArray& bytes) const;
+    void startSearch(qint64 from, bool forward);
+    void showMatch(qint64 hit, int length);
+
+    QFile file;
+    const uchar *mapped = nullptr;
+    qint64 mappedSize = 0;
+
+    QVector<qint64> lineStarts;
+    qint64 indexedBytes = 0;
+    qint64 longestLine = 0;
+    QFutureWatcher<IndexChunk> indexWatcher;
+    int indexGeneration = 0;
+
+    int currentLine = 0;
+    bool pendingReveal = false;
+    QFutureWatcher<SearchResult> searchWatcher;
+    QAtomicInt searchGeneration;
+    qint64 matchOffset = -1;
+    int matchLength = 0;
+    FindLineEdit *findEdit;
+};
+
+#endif // LARGEFILEVIEWER_H
@@ -0,0 +1,155 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "linediff.h"
+
+#include <QHash>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+// Above this edit distance the diff is not worth it: the whole changed zone
+// become a single edit
+static constexpr int MAX_EDIT_DISTANCE = 4096;
+
+namespace {
+
+using Match = std::pair<int, int>;
+
+// Myers O((N+M)D) diff. Only the diagonals reached on each step are stored
+// so the memory is O(D^2) instead of O((N+M)D)
+bool myersMatches(const int *a, int n, const int *b, int m, std::vector<Match>& matches)
+{
+    const int limit = std::min(n + m, MAX_EDIT_DISTANCE);
+    const int offset = limit + 1;
+    std::vector<int> v(static_cast<size_t>(2 * limit + 3), 0);
+    std::vector<std::vector<int>> trace;
+
+    auto at = [offset](std::vector<int>& vec, int k) -> int& { return vec[static_cast<size_t>(k + offset)]; };
+
+    for(int d = 0; d <= limit; d++) {
+        for(int k = -d; k <= d; k += 2) {
+            int x = (k == -d || (k != d && at(v, k - 1) < at(v, k + 1)))? at(v, k + 1) : at(v, k - 1) + 1;
+            int y = x - k;
+            while (x < n && y < m && a[x] == b[y]) {
+                x++;
+                y++;
+            }
+            at(v, k) = x;
+            if (x >= n && y >= m) {
+                // Backtrack collecting the diagonals
+                int cx = n;
+                int cy = m;
+                for(int e = d; e > 0; e--) {
+                    const auto& prev = trace[static_cast<size_t>(e - 1)];
+                    auto pv = [&prev, e](int kk) { return prev[static_cast<size_t>(kk + e - 1)]; };
+                    int ck = cx - cy;
+                    int pk = (ck == -e || (ck != e && pv(ck - 1) < pv(ck + 1)))? ck + 1 : ck - 1;
+                    int px = pv(pk);
+                    int py = px - pk;
+                    int sx = (pk == ck + 1)? px : px + 1;
+                    int sy = (pk == ck + 1)? py + 1 : py;
+                    while (cx > sx && cy > sy)
+                        matches.emplace_back(--cx, --cy);
+                    cx = px;
+                    cy = py;
+                }
+                while (cx > 0 && cy > 0)
+                    matches.emplace_back(--cx, --cy);
+                std::reverse(matches.begin(), matches.end());
+                return true;
+            }
+        }
+        std::vector<int> snapshot(static_cast<size_t>(2 * d + 1));
+        for(int k = -d; k <= d; k++)
+            snapshot[static_cast<size_t>(k + d)] = at(v, k);
+        trace.push_back(std::move(snapshot));
+    }
+    return false;
+}
+
+QVector<int> lineOffsets(const QByteArray& text)
+{
+    QVector<int> offsets{ 0 };
+    int pos = 0;
+    while ((pos = text.indexOf('\n', pos)) != -1)
+        offsets.append(++pos);
+    if (offsets.last() != text.size())
+        offsets.append(text.size());
+    return offsets;
+}
+
+}
+
+QVector<TextEdit> LineDiff::edits(const QByteArray &before, const QByteArray &after)
+{
+    QVector<TextEdit> result;
+    if (before == after)
+        return result;
+
+    const auto oldOffsets = lineOffsets(before);
+    const auto newOffsets = lineOffsets(after);
+    const int oldLines = oldOffsets.size() - 1;
+    const int newLines = newOffsets.size() - 1;
+    auto oldLine = [&](int i) { return before.mid(oldOffsets[i], oldOffsets[i + 1] - oldOffsets[i]); };
+    auto newLine = [&](int i) { return after.mid(newOffsets[i], newOffsets[i + 1] - newOffsets[i]); };
+
+    // Lines are compared by identity number
+    QHash<QByteArray, int> ids;
+    std::vector<int> a(static_cast<size_t>(oldLines));
+    std::vector<int> b(static_cast<size_t>(newLines));
+    for(int i = 0; i < oldLines; i++)
+        a[static_cast<size_t>(i)] = ids.insert(oldLine(i), ids.value(oldLine(i), ids.size())).value();
+    for(int i = 0; i < newLines; i++)
+        b[static_cast<size_t>(i)] = ids.insert(newLine(i), ids.value(newLine(i), ids.size())).value();
+
+    // Common prefix and suffix never enter the diff
+    int prefix = 0;
+    while (prefix < oldLines && prefix < newLines && a[static_cast<size_t>(prefix)] == b[static_cast<size_t>(prefix)])
+        prefix++;
+    int suffix = 0;
+    while (suffix < oldLines - prefix && suffix < newLines - prefix &&
+           a[static_cast<size_t>(oldLines - 1 - suffix)] == b[static_cast<size_t>(newLines - 1 - suffix)])
+        suffix++;
+
+    const int n = oldLines - prefix - suffix;
+    const int m = newLines - prefix - suffix;
+    std::vector<Match> matches;
+    if (!myersMatches(a.data() + prefix, n, b.data() + prefix, m, matches))
+        matches.clear();
+    matches.emplace_back(n, m); // sentinel
+
+    auto addEdit = [&](int oldStart, int oldCount, int newStart, int newCount) {
+        TextEdit edit;
+        edit.start = oldOffsets[prefix + oldStart];
+        edit.length = oldOffsets[prefix + oldStart + oldCount] - edit.start;
+        auto from = newOffsets[prefix + newStart];
+        edit.text = after.mid(from, newOffsets[prefix + newStart + newCount] - from);
+        result.append(edit);
+    };
+    int pa = 0;
+    int pb = 0;
+    for(const auto& match: matches) {
+        if (match.first > pa || match.second > pb)
+            addEdit(pa, match.first - pa, pb, match.second - pb);
+        pa = match.first + 1;
+        pb = match.second + 1;
+    }
+    return result;
+}
@@ -0,0 +1,88 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "linesplitter.h"
+
+#include <cstring>
+
+const LineSplitter::Batch &LineSplitter::push(const QByteArray &data)
+{
+    batch.clear();
+    joined.clear();
+    chunk = data;
+    auto begin = chunk.constData();
+    auto end = begin + chunk.size();
+    auto ptr = begin;
+    auto base = streamPos;
+    streamPos += chunk.size();
+
+    // UTF-8 never encodes '\n' inside a multibyte sequence, whole lines decode safely
+    if (!carry.isEmpty()) {
+        auto nl = static_cast<const char*>(std::memchr(ptr, '\n', size_t(end - ptr)));
+        if (!nl) {
+            carry.append(ptr, int(end - ptr));
+            return batch;
+        }
+        joined = carry;
+        joined.append(ptr, int(nl - ptr));
+        carry.clear();
+        addLine(joined.constData(), joined.size(), carryOffset);
+        ptr = nl + 1;
+    }
+    while (ptr < end) {
+        auto nl = static_cast<const char*>(std::memchr(ptr, '\n', size_t(end - ptr)));
+        if (!nl)
+            break;
+        addLine(ptr, int(nl - ptr), base + (ptr - begin));
+        ptr = nl + 1;
+    }
+    if (ptr < end) {
+        carry = QByteArray(ptr, int(end - ptr));
+        carryOffset = base + (ptr - begin);
+    }
+    return batch;
+}
+
+const LineSplitter::Batch &LineSplitter::flush()
+{
+    batch.clear();
+    chunk.clear();
+    joined.clear();
+    if (!carry.isEmpty()) {
+        joined.swap(carry);
+        addLine(joined.constData(), joined.size(), carryOffset);
+    }
+    return batch;
+}
+
+void LineSplitter::reset()
+{
+    batch.clear();
+    chunk.clear();
+    joined.clear();
+    carry.clear();
+    carryOffset = 0;
+    streamPos = 0;
+}
+
+void LineSplitter::addLine(const char *data, int size, qint64 offset)
+{
+    if (size > 0 && data[size - 1] == '\r')
+        size--;
+    batch.append({ data, size, offset });
+}
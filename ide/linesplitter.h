@@ -0,0 +1,57 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef LINESPLITTER_H
+#define LINESPLITTER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+class LineSplitter
+{
+public:
+    struct LineView {
+        const char *data; // Not terminated, without the line break
+        int size;
+        qint64 offset;    // Position of the first byte in the stream
+
+        QString toString() const { return QString::fromUtf8(data, size); }
+    };
+    using Batch = QVector<LineView>;
+
+    // Views are valid until the next call to push, flush or reset
+    const Batch& push(const QByteArray& data);
+    const Batch& flush();
+    void reset();
+
+    const QByteArray& pending() const { return carry; }
+    qint64 position() const { return streamPos; }
+
+private:
+    void addLine(const char *data, int size, qint64 offset);
+
+    QByteArray chunk;  // Shared with the caller, complete lines point into it
+    QByteArray joined; // A line started in a previous chunk
+    QByteArray carry;
+    qint64 carryOffset = 0;
+    qint64 streamPos = 0;
+    Batch batch;
+};
+
+#endif // LINESPLITTER_H
@@ -0,0 +1,294 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "livediagnostics.h"
+#include "appconfig.h"
+#include "buildmanager.h"
+#include "diagnosticmarks.h"
+#include "filecompiler.h"
+#include "idocumenteditor.h"
+
+#include <Qsci/qsciscintilla.h>
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QPointer>
+#include <QSaveFile>
+#include <QSet>
+#include <QTimer>
+
+#include <QtDebug>
+
+static constexpr int MAX_CACHED_RESULTS = 64;
+static constexpr int MAX_PREAMBLES = 16;
+
+static const QStringList SOURCE_SUFFIXES{ "c", "cpp", "cc", "cxx", "c++", "C", "S", "sx" };
+
+struct Preamble {
+    QByteArray header; // Leading #include lines, before anything that could change what they expand to
+    QByteArray body;   // The buffer with those lines blank, they come from the header
+};
+
+static Preamble splitPreamble(const QByteArray& text)
+{
+    Preamble preamble;
+    auto lines = text.split('\n');
+    bool inComment = false;
+    for (auto& raw: lines) {
+        auto line = raw.trimmed();
+        if (inComment) {
+            inComment = !line.contains("*/");
+            continue;
+        }
+        if (line.isEmpty() || line.startsWith("//"))
+            continue;
+        if (line.startsWith("/*")) {
+            inComment = !line.contains("*/");
+            continue;
+        }
+        if (!line.startsWith('#'))
+            break;
+        auto directive = line.mid(1).trimmed();
+        if (directive.startsWith("pragma once"))
+            continue;
+        if (!directive.startsWith("include"))
+            break;
+        preamble.header.append(line).append('\n');
+        raw.clear();
+    }
+    // Headers without guards must not be expanded twice, with and without the preamble
+    preamble.body = lines.join('\n');
+    return preamble;
+}
+
+class LiveDiagnostics::Priv_t
+{
+public:
+    struct File {
+        QPointer<QsciScintilla> editor;
+        IDocumentEditor *iface = nullptr;
+        QTimer *idle = nullptr;
+        int ticket = 0;
+        int generation = 0;
+        bool dirty = false;
+    };
+
+    FileCompiler *compiler;
+    BuildManager *builds;
+    QHash<QString, File> files;
+    QHash<QByteArray, QVector<BuildDiagnostic>> results;
+    QList<QByteArray> resultOrder;
+    QSet<QString> preamblesBuilding;
+    QSet<QString> preamblesFailed;
+
+    bool enabled() const { return AppConfig::instance().fileCheckLive(); }
+};
+
+LiveDiagnostics::LiveDiagnostics(FileCompiler *compiler, BuildManager *builds, QObject *parent) :
+    QObject(parent),
+    priv(std::make_unique<Priv_t>())
+{
+    priv->compiler = compiler;
+    priv->builds = builds;
+    connect(builds, &BuildManager::buildStarted, this, &LiveDiagnostics::suspend);
+    connect(builds, &BuildManager::buildTerminated, this, &LiveDiagnostics::invalidate);
+    connect(&AppConfig::instance(), &AppConfig::configChanged, this, &LiveDiagnostics::configChanged);
+}
+
+LiveDiagnostics::~LiveDiagnostics() = default;
+
+void LiveDiagnostics::watch(IDocumentEditor *iface)
+{
+    auto editor = qobject_cast<QsciScintilla*>(iface? iface->widget() : nullptr);
+    if (!editor || !iface->canSnapshot())
+        return;
+    auto path = iface->path();
+    if (!SOURCE_SUFFIXES.contains(QFileInfo(path).suffix()))
+        return;
+    auto& f = priv->files[path];
+    if (f.editor == editor)
+        return;
+    f.editor = editor;
+    f.iface = iface;
+    if (!f.idle) {
+        f.idle = new QTimer(this);
+        f.idle->setSingleShot(true);
+        connect(f.idle, &QTimer::timeout, this, [this, path]() { check(path); });
+    }
+    connect(editor, &QsciScintilla::textChanged, this, [this, path]() { schedule(path); });
+    connect(editor, &QObject::destroyed, this, [this, path, editor]() {
+        auto it = priv->files.find(path);
+        if (it == priv->files.end() || (it->editor && it->editor != editor))
+            return;
+        priv->compiler->cancel(it->ticket);
+        delete it->idle;
+        priv->files.erase(it);
+    });
+    schedule(path);
+}
+
+void LiveDiagnostics::schedule(const QString &path)
+{
+    auto it = priv->files.find(path);
+    if (it == priv->files.end() || !priv->enabled())
+        return;
+    it->idle->start(AppConfig::instance().fileCheckDelay());
+}
+
+void LiveDiagnostics::check(const QString &path)
+{
+    auto it = priv->files.find(path);
+    if (it == priv->files.end() || !it->editor || !priv->enabled())
+        return;
+    // Builds go first, the file is checked again when they finish
+    if (priv->builds->isBusy()) {
+        it->dirty = true;
+        return;
+    }
+    it->dirty = false;
+    // A newer buffer supersedes the check in flight
+    priv->compiler->cancel(it->ticket);
+    it->ticket = 0;
+    int generation = ++it->generation;
+    auto text = it->iface->snapshot().bytes;
+    auto key = QCryptographicHash::hash(path.toUtf8() + '\0' + text, QCryptographicHash::Sha1);
+    if (priv->results.contains(key)) {
+        setDiagnostics(path, priv->results.value(key));
+        return;
+    }
+    priv->compiler->commandFor(path, [this, path, generation, text, key](const CompileCommand& cmd) {
+        auto it = priv->files.find(path);
+        // Files outside of the build have nothing to be checked with
+        if (!cmd.isValid() || it == priv->files.end() || it->generation != generation)
+            return;
+        auto preamble = splitPreamble(text);
+        auto extra = preambleArguments(cmd, preamble.header);
+        it->ticket = priv->compiler->compile(path, extra.isEmpty()? text : preamble.body, true, [this, path, generation, key](int code, const QByteArray& out) {
+            auto it = priv->files.find(path);
+            if (it == priv->files.end() || it->generation != generation)
+                return;
+            it->ticket = 0;
+            auto list = parse(path, code, out);
+            priv->results.insert(key, list);
+            priv->resultOrder.append(key);
+            while (priv->resultOrder.size() > MAX_CACHED_RESULTS)
+                priv->results.remove(priv->resultOrder.takeFirst());
+            setDiagnostics(path, list);
+        }, extra);
+    });
+}
+
+QStringList LiveDiagnostics::preambleArguments(const CompileCommand &cmd, const QByteArray &preamble)
+{
+    auto lang = FileCompiler::languageOf(cmd.file);
+    if (preamble.isEmpty() || (lang != "c" && lang != "c++"))
+        return QStringList();
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(cmd.directory.toUtf8());
+    hash.addData(cmd.compiler.toUtf8());
+    hash.addData(FileCompiler::baseArguments(cmd).join('\n').toUtf8());
+    hash.addData(preamble);
+    auto name = QString(hash.result().toHex());
+    QDir dir(AppConfig::ensureExist(QDir(AppConfig::instance().workspacePath()).filePath("preambles")));
+    auto header = dir.filePath(name + ".h");
+    // gcc and clang pick the precompiled form of an -include header by themselves
+    auto pch = header + (QFileInfo(cmd.compiler).fileName().contains("clang")? ".pch" : ".gch");
+    if (QFile::exists(pch))
+        return QStringList{ "-include", header };
+    if (priv->preamblesBuilding.contains(name) || priv->preamblesFailed.contains(name))
+        return QStringList();
+
+    auto old = dir.entryInfoList({ "*.h" }, QDir::Files, QDir::Time);
+    for (const auto& info: old.mid(MAX_PREAMBLES - 1))
+        for (const auto& suffix: { "", ".gch", ".pch" })
+            QFile::remove(info.absoluteFilePath() + suffix);
+    QSaveFile f(header);
+    if (!f.open(QFile::WriteOnly) || f.write(preamble) != preamble.size() || !f.commit())
+        return QStringList();
+    // Until the precompiled preamble is ready the checks parse the headers
+    priv->preamblesBuilding.insert(name);
+    auto partial = pch + ".part";
+    priv->compiler->precompile(cmd.file, header, partial, [this, name, pch, partial](int code, const QByteArray& out) {
+        priv->preamblesBuilding.remove(name);
+        if (code == 0 && QFile::rename(partial, pch))
+            return;
+        qDebug() << "preamble failed:" << out;
+        QFile::remove(partial);
+        priv->preamblesFailed.insert(name);
+    });
+    return QStringList();
+}
+
+void LiveDiagnostics::setDiagnostics(const QString &path, const QVector<BuildDiagnostic> &list)
+{
+    auto it = priv->files.find(path);
+    if (it != priv->files.end() && it->editor)
+        DiagnosticMarks::of(it->editor)->setDiagnostics(list);
+}
+
+QVector<BuildDiagnostic> LiveDiagnostics::parse(const QString &path, int exitCode, const QByteArray &output)
+{
+    QVector<BuildDiagnostic> list;
+    auto file = QDir::cleanPath(QFileInfo(path).absoluteFilePath());
+    BuildOutputParser parser;
+    connect(&parser, &BuildOutputParser::batchReady, [&list, &file](const BuildOutputBatch& batch) {
+        // Problems inside the headers belong to other documents
+        for (const auto& d: batch.diagnostics)
+            if (d.severity != BuildDiagnostic::Severity::Note && d.file == file)
+                list.append(d);
+    });
+    parser.reset(QFileInfo(file).absolutePath());
+    parser.pushData(output);
+    parser.finish(exitCode);
+    return list;
+}
+
+void LiveDiagnostics::invalidate()
+{
+    priv->results.clear();
+    priv->resultOrder.clear();
+    for (auto it = priv->files.begin(); it != priv->files.end(); ++it)
+        schedule(it.key());
+}
+
+void LiveDiagnostics::suspend()
+{
+    for (auto& f: priv->files) {
+        if (f.ticket) {
+            priv->compiler->cancel(f.ticket);
+            f.ticket = 0;
+            f.dirty = true;
+        }
+    }
+}
+
+void LiveDiagnostics::configChanged()
+{
+    if (priv->enabled())
+        return;
+    for (auto& f: priv->files) {
+        priv->compiler->cancel(f.ticket);
+        f.ticket = 0;
+        f.idle->stop();
+        if (f.editor)
+            DiagnosticMarks::of(f.editor)->clear();
+    }
+}
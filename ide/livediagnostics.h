@@ -0,0 +1,64 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef LIVEDIAGNOSTICS_H
+#define LIVEDIAGNOSTICS_H
+
+#include "buildoutputparser.h"
+
+#include <QObject>
+
+#include <memory>
+
+class BuildManager;
+class FileCompiler;
+class IDocumentEditor;
+struct CompileCommand;
+
+// Checks the open C/C++ sources with their real flags a while after the
+// last edit and marks the diagnostics in the editors
+class LiveDiagnostics : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LiveDiagnostics(FileCompiler *compiler, BuildManager *builds, QObject *parent = nullptr);
+    ~LiveDiagnostics() override;
+
+    void watch(IDocumentEditor *editor);
+    void setDiagnostics(const QString& path, const QVector<BuildDiagnostic>& list);
+
+    static QVector<BuildDiagnostic> parse(const QString& path, int exitCode, const QByteArray& output);
+
+public slots:
+    // Results are kept by content, a saved header or a build make them stale
+    void invalidate();
+
+private slots:
+    void suspend();
+    void configChanged();
+
+private:
+    void schedule(const QString& path);
+    void check(const QString& path);
+    QStringList preambleArguments(const CompileCommand& cmd, const QByteArray& preamble);
+
+    class Priv_t;
+    std::unique_ptr<Priv_t> priv;
+};
+
+#endif // LIVEDIAGNOSTICS_H
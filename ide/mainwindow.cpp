@@ -23,6 +23,7 @@
 #include "appconfig.h"
 #include "buildmanager.h"
 #include "consoleinterceptor.h"
+#include "consoleview.h"
 #include "filesystemmanager.h"
 #include "idocumenteditor.h"
 #include "externaltoolmanager.h"
@@ -35,26 +36,47 @@
 #include "findinfilesdialog.h"
 #include "clangautocompletionprovider.h"
 #include "textmessagebrocker.h"
-#include "regexhtmltranslator.h"
 #include "templatemanager.h"
 #include "templateitemwidget.h"
 #include "templatefile.h"
-#include "processlinebufferizer.h"
+#include "buildoutputparser.h"
+#include "buildlogstore.h"
+#include "buildtimeline.h"
+#include "compilecache.h"
+#include "filecompiler.h"
+#include "livediagnostics.h"
+#include "includegraph.h"
+#include "filereferencesdialog.h"
+#include "buildproblemsmodel.h"
 #include "newprojectfromremotedialog.h"
 #include "findmakefiledialog.h"
+#include "projectformatter.h"
+#include "documentio.h"
+#include "editjournal.h"
 
 #include <QCloseEvent>
+#include <QCursor>
+#include <QCryptographicHash>
 #include <QFileDialog>
+#include <QFutureWatcher>
+#include <QInputDialog>
 #include <QStringListModel>
 #include <QScrollBar>
+#include <QApplication>
 #include <QMenu>
 #include <QMessageBox>
 #include <QFileSystemModel>
 #include <QShortcut>
 #include <QStandardItemModel>
 #include <QFileSystemWatcher>
-#include <QTextBrowser>
+#include <QJsonDocument>
+#include <QSaveFile>
 #include <QDialogButtonBox>
+#include <QHeaderView>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QtConcurrent>
+#include <QTimer>
 
 #include <QtDebug>
 
@@ -73,16 +95,34 @@ public:
     ProcessManager *pman;
     ConsoleInterceptor *console;
     BuildManager *buildManager;
+    ProjectFormatter *projectFormatter;
     LineRangeList lineRanges;
     QString lastDir;
     bool documentOnly = false;
     QByteArray topSplitterState;
     QByteArray docSplitterState;
-    QVector<QString> trackedBuildPath;
+    QThread *buildOutputThread;
+    BuildOutputParser *buildOutputParser; // Output of the tools on the plain build process
+    QHash<int, BuildOutputParser*> buildParsers;
+    QHash<int, QString> buildTargets; // Builds of the running session
+    QHash<int, QString> queueLogs;
+    BuildProblemsModel *problems;
+    FileCompiler *fileCompiler;
+    LiveDiagnostics *liveDiagnostics;
+    std::shared_ptr<IncludeGraph> includeGraph; // Shared with the refresh running in background
+    QString sessionProject;
 };
 
 
 static constexpr auto MAINWINDOW_SIZE = QSize{900, 600};
+static constexpr int FILE_CHECK_ID = -1; // Build id of the single file compilations
+
+static QString sessionFilePath(const QString& projectFile)
+{
+    auto dir = AppConfig::ensureExist(QDir(AppConfig::instance().workspacePath()).filePath("sessions"));
+    auto name = QCryptographicHash::hash(projectFile.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return QDir(dir).filePath(QString("%1.json").arg(QString(name)));
+}
 
 static QString kindToIcon(const QString& kind)
 {
@@ -134,6 +174,7 @@ MainWindow::MainWindow(QWidget *parent) :
         { ui->buttonDocumentCloseAll, "document-close-all" },
         { ui->buttonDocumentSaveAll, "document-save-all" },
         { ui->buttonDocumentReload, "view-refresh" },
+        { ui->buttonDocumentCompile, "run-build" },
         { ui->updateAvailable, "view-refresh" },
         { ui->buttonQuit, "application-exit" },
         { ui->buttonConfiguration, "configure" },
@@ -216,78 +257,8 @@ MainWindow::MainWindow(QWidget *parent) :
 
     priv->console = new ConsoleInterceptor(ui->logView, this);
 
-    auto currentPathTracker = [this](QTextBrowser *b, QString& s) -> bool {
-        Q_UNUSED(b)
-        auto &stack = priv->trackedBuildPath;
-        static const QRegularExpression re(R"(make\[(\d+)\]\: (Entering|Leaving) directory \'([^\']*)\')");
-        auto m = re.match(s);
-        if (m.hasMatch()) {
-            auto level = m.captured(1).toInt();
-            auto path = m.captured(3);
-            if (stack.size() < level) {
-                stack.resize(level);
-            }
-            stack[level - 1] = path;
-        }
-        return false;
-    };
-    auto errorStringFinder = [this](QTextBrowser *b, QString& s) -> bool {
-        Q_UNUSED(b)
-        static const QRegularExpression errRe(
-            R"(^(?<file>.*?):(?<line>\d+):(?<col>\d+)?(?<ddot>:?)(?<msg>.*?)$)",
-            QRegularExpression::MultilineOption
-        );
-        auto mit = errRe.globalMatch(s);
-        int count = 0;
-        int pos = 0;
-        while (mit.hasNext()) {
-            auto mm = mit.next();
-            int reStart = mm.capturedStart();
-            if (reStart > pos) {
-                ConsoleInterceptor::writeMessageTo(b, s.mid(pos, reStart - pos));
-            }
-            QString file = mm.captured("file");
-            if (!priv->trackedBuildPath.isEmpty() && !QFileInfo(file).isAbsolute())
-                file.prepend(priv->trackedBuildPath.last() + QDir::separator());
-            auto line = mm.captured("line");
-            auto col = mm.captured("col");
-            auto ddot = mm.captured("ddot");
-            auto msg = mm.captured("msg");
-            auto url = ICodeModelProvider::FileReference(file, line.toInt(), col.toInt(), msg).encode();
-            auto err = QString("%2:%3:%4%5 ").arg(file, line, col, ddot);
-            ConsoleInterceptor::writeMessageTo(b, err, Qt::red);
-            QTextCharFormat linkFmt;
-            linkFmt.setAnchor(true);
-            linkFmt.setAnchorHref(url.toString());
-            linkFmt.setForeground(b->palette().link().color());
-            ConsoleInterceptor::writeMessageTo(b, msg, linkFmt);
-            pos = mm.capturedEnd();
-            count++;
-        }
-        if (count > 0 && pos < s.length()) {
-            ConsoleInterceptor::writeMessageTo(b, s.mid(pos));
-            return true;
-        }
-        return false;
-    };
-    priv->console->addStdErrFilter(currentPathTracker);
-    priv->console->addStdOutFilter(currentPathTracker);
-    priv->console->addStdErrFilter(errorStringFinder);
-    priv->console->addStdOutFilter(errorStringFinder);
-
-    connect(priv->console->clearButton(), &QToolButton::clicked,
-            ui->logView, &QTextBrowser::clear);
-
     auto makeProc = priv->pman->processFor(BuildManager::PROCESS_NAME);
-    connect(makeProc, &QProcess::stateChanged,
-            [this](QProcess::ProcessState state) {
-                priv->console->killButton()->setEnabled(state == QProcess::Running);
-            });
-    auto makeLinerize = new ProcessLineBufferizer(ProcessLineBufferizer::MergedChannel, makeProc);
-    connect(makeLinerize, &ProcessLineBufferizer::haveLine, this, [this, makeProc](const QString& line) {
-            priv->console->appendToConsole(QProcess::StandardError, makeProc, line);
-    });
-    connect(priv->buildManager, &BuildManager::buildTerminated, makeLinerize, &ProcessLineBufferizer::flush);
+    makeProc->setProcessChannelMode(QProcess::MergedChannels);
 
     priv->projectManager = new ProjectManager(ui->actionViewer, priv->pman, this);
     priv->projectManager->setCodeModelProvider(new ClangAutocompletionProvider(priv->projectManager, this));
@@ -296,40 +267,175 @@ MainWindow::MainWindow(QWidget *parent) :
     priv->buildManager = new BuildManager(priv->projectManager, priv->pman, this);
     connect(priv->console->killButton(), &QToolButton::clicked,
             priv->buildManager, &BuildManager::cancelBuild);
+    auto updateKillButton = [this, makeProc]() {
+        priv->console->killButton()->setEnabled(priv->buildManager->isBusy() || makeProc->state() == QProcess::Running);
+    };
+    connect(makeProc, &QProcess::stateChanged, this, updateKillButton);
+    connect(priv->buildManager, &BuildManager::queueChanged, this, updateKillButton);
+    connect(priv->buildManager, &BuildManager::queueChanged, this, &MainWindow::updateBuildQueue);
+    ui->queueView->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+    connect(ui->queueView, &QTreeWidget::customContextMenuRequested, this, [this](const QPoint& pos) {
+        auto item = ui->queueView->itemAt(pos);
+        if (!item)
+            return;
+        auto id = item->data(0, Qt::UserRole).toInt();
+        auto logBase = item->data(1, Qt::UserRole).toString();
+        QMenu menu;
+        menu.addAction(tr("Cancel"), [this, id]() { priv->buildManager->cancel(id); })
+                ->setEnabled(priv->buildManager->isBusy());
+        menu.addAction(tr("Cancel All"), priv->buildManager, &BuildManager::cancelBuild)
+                ->setEnabled(priv->buildManager->isBusy());
+        menu.addAction(tr("Search Log..."), [this, logBase]() {
+            for (const auto& log: BuildLogStore::builds(priv->projectManager->projectFile()))
+                if (log.basePath == logBase)
+                    searchBuildLog(log);
+        })->setEnabled(!logBase.isEmpty());
+        menu.exec(ui->queueView->viewport()->mapToGlobal(pos));
+    });
+
+    priv->problems = new BuildProblemsModel(this);
+    ui->problemsView->setModel(priv->problems);
+    ui->problemsView->header()->setSectionResizeMode(BuildProblemsModel::MessageColumn, QHeaderView::Stretch);
+    connect(ui->problemsView, &QTreeView::activated, [this](const QModelIndex& index) {
+        auto d = priv->problems->diagnostic(index);
+        if (d) {
+            ui->documentContainer->openDocumentHere(d->file, d->line, qMax(0, d->column));
+            ui->documentContainer->setFocus();
+        }
+    });
+
+    // Raw make output is split and parsed in its own thread, only records come back
+    priv->buildOutputThread = new QThread(this);
+    priv->buildOutputThread->start();
+    priv->buildOutputParser = createBuildParser(0);
+    connect(makeProc, &QProcess::readyRead, this, [this, makeProc]() {
+        QMetaObject::invokeMethod(priv->buildOutputParser, "pushData", Qt::QueuedConnection,
+                                  Q_ARG(QByteArray, makeProc->readAll()));
+    });
+    connect(makeProc, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            priv->buildOutputParser, &BuildOutputParser::finish);
+    // Every build of the queue has its own parser and log, demultiplexed by id
+    connect(priv->buildManager, &BuildManager::entryStarted, this, [this](int id, const QString& target) {
+        auto parser = createBuildParser(id);
+        auto logBase = QString("%1-%2").arg(BuildLogStore::newLogBase(priv->projectManager->projectFile())).arg(id);
+        QMetaObject::invokeMethod(parser, "reset", Qt::QueuedConnection,
+                                  Q_ARG(QString, priv->projectManager->projectPath()),
+                                  Q_ARG(QString, logBase),
+                                  Q_ARG(QString, target));
+        priv->buildParsers.insert(id, parser);
+        priv->buildTargets.insert(id, target);
+        priv->queueLogs.insert(id, logBase);
+        updateBuildQueue();
+    });
+    connect(priv->buildManager, &BuildManager::entryOutput, this, [this](int id, const QByteArray& data) {
+        auto parser = priv->buildParsers.value(id);
+        if (parser)
+            QMetaObject::invokeMethod(parser, "pushData", Qt::QueuedConnection, Q_ARG(QByteArray, data));
+    });
+    connect(priv->buildManager, &BuildManager::entryFinished, this, [this](int id, int code) {
+        auto parser = priv->buildParsers.take(id);
+        if (parser) {
+            // Queued after the last data, the final batch goes out before the parser is gone
+            QMetaObject::invokeMethod(parser, "finish", Qt::QueuedConnection, Q_ARG(int, code));
+            parser->deleteLater();
+        }
+    });
+    connect(priv->console->historyButton()->menu(), &QMenu::aboutToShow, this, [this]() {
+        auto menu = priv->console->historyButton()->menu();
+        populateBuildHistory(menu);
+        menu->addSeparator();
+        menu->addAction(tr("Message Statistics"), this, &MainWindow::showMessageStatistics);
+    });
 
     priv->fileManager = new FileSystemManager(ui->fileViewer, this);
 
-    connect(ui->logView, &QTextBrowser::anchorClicked, [this](const QUrl& url) {
+    connect(ui->logView, &ConsoleView::anchorClicked, [this](const QUrl& url) {
         auto ref = ICodeModelProvider::FileReference::decode(url);
         ui->documentContainer->openDocumentHere(ref.path, ref.line, ref.column);
         ui->documentContainer->setFocus();
     });
 
-    TextMessageBrocker::instance().subscribe(TextMessages::STDERR_LOG, [this](const QString& msg) {
-        priv->console->writeMessage(msg);
+    TextMessageBrocker::instance().subscribe(TextMessages::STDERR_LOG, this, [this](const QString& msg) {
+        priv->console->appendToConsole(QProcess::StandardError, nullptr, msg);
     });
 
-    TextMessageBrocker::instance().subscribe(TextMessages::STDOUT_LOG, [this](const QString& msg) {
-        priv->console->writeMessage(msg);
+    TextMessageBrocker::instance().subscribe(TextMessages::STDOUT_LOG, this, [this](const QString& msg) {
+        priv->console->appendToConsole(QProcess::StandardOutput, nullptr, msg);
     });
 
     connect(priv->buildManager, &BuildManager::buildStarted, [this]() {
-        priv->trackedBuildPath.clear();
-        ui->actionViewer->setEnabled(false);
+        QMetaObject::invokeMethod(priv->buildOutputParser, "reset", Qt::QueuedConnection,
+                                  Q_ARG(QString, priv->projectManager->projectPath()));
+        priv->buildTargets.clear();
+        priv->problems->clear();
+        ui->logTabs->setTabText(ui->logTabs->indexOf(ui->problemsTab), tr("Problems"));
     });
+    connect(priv->buildManager, &BuildManager::buildTerminated, this, &MainWindow::refreshIncludeGraph);
     connect(priv->buildManager, &BuildManager::buildTerminated, [this]() {
-        ui->actionViewer->setEnabled(true);
+        if (priv->buildManager->compileCacheActive()) {
+            auto maxBytes = qint64(AppConfig::instance().compileCacheMaxSize()) * 1024 * 1024;
+            auto watcher = new QFutureWatcher<CompileCache::Report>(this);
+            connect(watcher, &QFutureWatcher<CompileCache::Report>::finished, this, [this, watcher]() {
+                watcher->deleteLater();
+                auto r = watcher->result();
+                auto total = r.hits + r.misses;
+                priv->console->writeMessage(tr("Compile cache: %1 hits, %2 misses (%3% hit rate), %4 MB used%5\n")
+                                            .arg(r.hits).arg(r.misses)
+                                            .arg(total? r.hits * 100 / total : 0)
+                                            .arg(r.size / (1024 * 1024))
+                                            .arg(r.evicted? tr(", %1 entries evicted").arg(r.evicted) : QString()),
+                                            Qt::darkGreen);
+            });
+            watcher->setFuture(QtConcurrent::run(&CompileCache::collect, CompileCache::path(), maxBytes));
+        }
+        auto trace = priv->buildManager->traceFile();
+        if (trace.isEmpty())
+            return;
+        auto projectFile = priv->projectManager->projectFile();
+        auto projectPath = priv->projectManager->projectPath();
+        using Result = QPair<QVector<BuildStep>, QHash<QString, QVector<int>>>;
+        auto watcher = new QFutureWatcher<Result>(this);
+        connect(watcher, &QFutureWatcher<Result>::finished, this, [this, watcher]() {
+            watcher->deleteLater();
+            auto r = watcher->result();
+            ui->timelineView->setSteps(r.first, r.second);
+        });
+        watcher->setFuture(QtConcurrent::run([trace, projectFile, projectPath]() {
+            auto steps = BuildTimeline::load(trace, projectPath);
+            BuildTimeline::appendHistory(projectFile, steps);
+            return Result(steps, BuildTimeline::history(projectFile));
+        }));
+    });
+    connect(ui->timelineView, &BuildTimelineView::fileActivated, [this](const QString& path) {
+        ui->documentContainer->openDocumentHere(path, 1, 0);
+        ui->documentContainer->setFocus();
     });
     connect(priv->projectManager, &ProjectManager::targetTriggered, [this](const QString& target) {
-        ui->logView->clear();
+        // Ctrl runs the target next to the queued ones instead of after them
+        bool parallel = QApplication::keyboardModifiers().testFlag(Qt::ControlModifier);
+        auto enqueue = [this, target, parallel]() {
+            if (parallel)
+                priv->buildManager->startParallelBuild(target);
+            else
+                priv->buildManager->startBuild(target);
+        };
+        if (!priv->buildManager->isBusy())
+            ui->logView->clear();
         auto unsaved = ui->documentContainer->unsavedDocuments();
         if (!unsaved.isEmpty()) {
             UnsavedFilesDialog d(unsaved, this);
             if (d.exec() == QDialog::Rejected)
                 return;
-            ui->documentContainer->saveDocuments(d.checkedForSave());
+            // make starts once the last write is renamed in place
+            ui->documentContainer->saveDocuments(d.checkedForSave(), [this, enqueue](bool ok) {
+                if (ok)
+                    enqueue();
+                else
+                    priv->console->writeMessage(tr("Build canceled, some documents cannot be saved"), Qt::red);
+            });
+            return;
         }
-        priv->buildManager->startBuild(target);
+        enqueue();
     });
     connect(priv->fileManager, &FileSystemManager::requestFileOpen, ui->documentContainer, &DocumentManager::openDocument);
 
@@ -442,10 +548,17 @@ MainWindow::MainWindow(QWidget *parent) :
         AppConfig::instance().save();
         qputenv("CURRENT_PROJECT_FILE", filepath.toLocal8Bit());
         qputenv("CURRENT_PROJECT_DIR", dirpath.toLocal8Bit());
+        priv->sessionProject = filepath;
+        auto session = QJsonDocument::fromJson(AppConfig::readEntireTextFile(sessionFilePath(filepath)));
+        ui->documentContainer->restoreSession(session.object());
+        priv->includeGraph = std::make_shared<IncludeGraph>();
+        refreshIncludeGraph();
     });
     connect(priv->projectManager, &ProjectManager::projectClosed, [this, makeRecentProjects]() {
         qputenv("CURRENT_PROJECT_FILE", "");
         qputenv("CURRENT_PROJECT_DIR", "");
+        saveSession();
+        priv->sessionProject.clear();
         bool ok = ui->documentContainer->aboutToCloseAll();
         qDebug() << "can close" << ok;
         if (ok) {
@@ -453,6 +566,7 @@ MainWindow::MainWindow(QWidget *parent) :
             makeRecentProjects();
             ui->stackedWidget->setCurrentWidget(ui->welcomePage);
             priv->fileManager->closePath();
+            priv->includeGraph = std::make_shared<IncludeGraph>();
         }
     });
 
@@ -464,6 +578,7 @@ MainWindow::MainWindow(QWidget *parent) :
         ui->buttonDocumentClose->setEnabled(haveDocuments);
         ui->buttonDocumentCloseAll->setEnabled(haveDocuments);
         ui->buttonDocumentReload->setEnabled(haveDocuments);
+        ui->buttonDocumentCompile->setEnabled(haveDocuments);
         ui->buttonDocumentSave->setEnabled(isModified);
         ui->buttonDocumentSaveAll->setEnabled(ui->documentContainer->unsavedDocuments().count() > 0);
         ui->symbolSelector->setEnabled(false);
@@ -566,9 +681,61 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(ui->buttonDocumentSave, &QToolButton::clicked, ui->documentContainer, &DocumentManager::saveCurrent);
     connect(ui->buttonDocumentSaveAll, &QToolButton::clicked, ui->documentContainer, &DocumentManager::saveAll);
     connect(ui->buttonDocumentReload, &QToolButton::clicked, ui->documentContainer, &DocumentManager::reloadDocumentCurrent);
+    priv->fileCompiler = new FileCompiler(priv->projectManager, this);
+    priv->liveDiagnostics = new LiveDiagnostics(priv->fileCompiler, priv->buildManager, this);
+    connect(ui->documentContainer, &DocumentManager::documentFocushed, this, [this](const QString& path) {
+        priv->liveDiagnostics->watch(ui->documentContainer->documentEditor(path));
+    });
+    connect(ui->documentContainer, &DocumentManager::documentModified, this, [this](const QString& path, IDocumentEditor *iface, bool modify) {
+        Q_UNUSED(path)
+        Q_UNUSED(iface)
+        if (!modify)
+            priv->liveDiagnostics->invalidate();
+    });
+    connect(ui->buttonDocumentCompile, &QToolButton::clicked, this, &MainWindow::compileCurrentFile);
+    connect(new QShortcut(QKeySequence("CTRL+F7"), this), &QShortcut::activated, this, &MainWindow::compileCurrentFile);
+    priv->includeGraph = std::make_shared<IncludeGraph>();
+    connect(priv->fileManager, &FileSystemManager::aboutToShowContextMenu, this, [this](QMenu *menu, const QFileInfo& info) {
+        addIncludeGraphActions(menu, info.absoluteFilePath());
+    });
+    connect(new QShortcut(QKeySequence("CTRL+SHIFT+H"), this), &QShortcut::activated, [this]() {
+        auto path = ui->documentContainer->documentCurrent();
+        if (path.isEmpty())
+            return;
+        QMenu menu(this);
+        addIncludeGraphActions(&menu, path);
+        if (!menu.isEmpty())
+            menu.exec(QCursor::pos());
+    });
 
-    auto setExternalTools = [this]() {
+    priv->projectFormatter = new ProjectFormatter(this);
+    auto formatProjectCallback = [this]() {
+        if (!priv->projectManager->isProjectOpen() || priv->projectFormatter->isRunning())
+            return;
+        priv->projectFormatter->start(priv->projectManager->projectPath(),
+                                      ui->documentContainer->unsavedDocuments());
+    };
+    connect(priv->projectFormatter, &ProjectFormatter::started, [this](int count) {
+        priv->console->writeMessage(tr("Formatting %1 project sources...").arg(count), Qt::darkGreen);
+    });
+    connect(priv->projectFormatter, &ProjectFormatter::errorMessage, [this](const QString& msg) {
+        priv->console->writeMessage(msg, Qt::red);
+    });
+    connect(priv->projectFormatter, &ProjectFormatter::finished,
+            [this](const QStringList& touched, int total, qint64 elapsed) {
+        for(const auto& path: touched) {
+            if (ui->documentContainer->documentEditor(path))
+                ui->documentContainer->reloadDocument(path);
+        }
+        priv->console->writeMessage(tr("Formatted %1 of %2 files in %3 ms")
+                                    .arg(touched.count()).arg(total).arg(elapsed), Qt::darkGreen);
+    });
+    connect(new QShortcut(QKeySequence("CTRL+ALT+I"), this), &QShortcut::activated, formatProjectCallback);
+
+    auto setExternalTools = [this, formatProjectCallback]() {
         auto m = ExternalToolManager::makeMenu(this, priv->pman, priv->projectManager);
+        m->addAction(QIcon(AppConfig::resourceImage({ "actions", "code-context" })),
+                     tr("Format Project Sources"), formatProjectCallback)->setShortcut(QKeySequence("CTRL+ALT+I"));
         ui->buttonTools->setMenu(m);
         // ui->buttonExternalTools->setMenu(m);
     };
@@ -611,20 +778,233 @@ MainWindow::MainWindow(QWidget *parent) :
             ui->bottomLeftStack->setCurrentWidget(ui->actionViewer);
         }
     });
+
+    QTimer::singleShot(0, this, &MainWindow::recoverJournals);
 }
 
 MainWindow::~MainWindow()
 {
+    priv->buildOutputThread->quit();
+    priv->buildOutputThread->wait();
     TextMessageBrocker::instance().disconnect();
 }
 
+BuildOutputParser *MainWindow::createBuildParser(int id)
+{
+    auto parser = new BuildOutputParser(id);
+    parser->moveToThread(priv->buildOutputThread);
+    connect(priv->buildOutputThread, &QThread::finished, parser, &QObject::deleteLater);
+    connect(parser, &BuildOutputParser::batchReady, this, &MainWindow::renderBuildBatch);
+    return parser;
+}
+
+void MainWindow::renderBuildBatch(const BuildOutputBatch &batch)
+{
+    // Lines of concurrent builds interleave, each one tells where it comes from
+    auto prefix = priv->buildTargets.size() > 1? priv->buildTargets.value(batch.buildId) : QString();
+    if (!prefix.isEmpty())
+        prefix = QString("[%1] ").arg(prefix);
+    static const QColor prefixColors[] = { Qt::darkBlue, Qt::darkMagenta, Qt::darkCyan, Qt::darkGreen };
+    auto prefixColor = prefixColors[qAbs(batch.buildId) % int(sizeof(prefixColors) / sizeof(*prefixColors))];
+    QString plain;
+    for(int i = 0; i < batch.lines.size(); i++) {
+        const auto& text = batch.lines.at(i);
+        if (!prefix.isEmpty()) {
+            if (!plain.isEmpty()) {
+                ConsoleInterceptor::writeMessageTo(ui->logView, plain);
+                plain.clear();
+            }
+            ConsoleInterceptor::writeMessageTo(ui->logView, prefix, prefixColor);
+        }
+        int idx = batch.lineDiagnostic.at(i);
+        const auto& spans = batch.lineSpans.at(i);
+        if (idx < 0 && spans.isEmpty()) {
+            plain.append(text).append('\n');
+            continue;
+        }
+        if (!plain.isEmpty()) {
+            ConsoleInterceptor::writeMessageTo(ui->logView, plain);
+            plain.clear();
+        }
+        if (idx < 0) {
+            for (const auto& s: spans)
+                ConsoleInterceptor::writeMessageTo(ui->logView, text.mid(s.start, s.length), s.format);
+            plain.append('\n');
+            continue;
+        }
+        const auto& d = batch.diagnostics.at(idx);
+        auto color = d.severity == BuildDiagnostic::Severity::Warning? QColor(Qt::darkYellow) :
+                     d.severity == BuildDiagnostic::Severity::Note? QColor(Qt::darkGray) : QColor(Qt::red);
+        ConsoleInterceptor::writeMessageTo(ui->logView, text.left(text.size() - d.message.size()), color);
+        QTextCharFormat linkFmt;
+        linkFmt.setAnchor(true);
+        linkFmt.setAnchorHref(ICodeModelProvider::FileReference(d.file, d.line, qMax(0, d.column), d.message).encode().toString());
+        linkFmt.setForeground(ui->logView->palette().link().color());
+        ConsoleInterceptor::writeMessageTo(ui->logView, d.message, linkFmt);
+        plain.append('\n');
+    }
+    if (!plain.isEmpty())
+        ConsoleInterceptor::writeMessageTo(ui->logView, plain);
+    if (!batch.diagnostics.isEmpty()) {
+        priv->problems->appendDiagnostics(batch.diagnostics, batch.buildId);
+        ui->logTabs->setTabText(ui->logTabs->indexOf(ui->problemsTab),
+                                tr("Problems (%1 errors, %2 warnings)")
+                                    .arg(priv->problems->errorCount())
+                                    .arg(priv->problems->warningCount()));
+    }
+}
+
+void MainWindow::compileCurrentFile()
+{
+    auto ed = ui->documentContainer->documentEditorCurrent();
+    if (!ed || !priv->projectManager->isProjectOpen())
+        return;
+    auto path = ed->path();
+    auto unsaved = ed->isModified() && ed->canSnapshot()? ed->snapshot().bytes : QByteArray();
+    priv->console->writeMessage(tr("Compiling %1\n").arg(QFileInfo(path).fileName()), Qt::darkGreen);
+    QElapsedTimer elapsed;
+    elapsed.start();
+    priv->fileCompiler->compile(path, unsaved, AppConfig::instance().fileCheckSyntaxOnly(),
+                                [this, path, elapsed](int exitCode, const QByteArray& output) {
+        if (!priv->buildManager->isBusy()) {
+            priv->problems->clear();
+            ui->logTabs->setTabText(ui->logTabs->indexOf(ui->problemsTab), tr("Problems"));
+        }
+        // Parsed right here, the output of a single file is small
+        BuildOutputParser parser(FILE_CHECK_ID);
+        connect(&parser, &BuildOutputParser::batchReady, this, &MainWindow::renderBuildBatch);
+        parser.reset(QFileInfo(path).absolutePath());
+        parser.pushData(output);
+        parser.finish(exitCode);
+        priv->liveDiagnostics->setDiagnostics(path, LiveDiagnostics::parse(path, exitCode, output));
+        priv->console->writeMessage(tr("%1 %2 in %3 ms\n")
+                                    .arg(QFileInfo(path).fileName())
+                                    .arg(exitCode == 0? tr("compiled") : tr("failed"))
+                                    .arg(elapsed.elapsed()),
+                                    exitCode == 0? Qt::darkGreen : Qt::red);
+    });
+}
+
+void MainWindow::refreshIncludeGraph()
+{
+    if (!priv->projectManager->isProjectOpen())
+        return;
+    auto graph = priv->includeGraph;
+    auto root = priv->projectManager->projectPath();
+    QtConcurrent::run([graph, root]() { graph->refresh(root); });
+}
+
+void MainWindow::addIncludeGraphActions(QMenu *menu, const QString &path)
+{
+    auto graph = priv->includeGraph;
+    auto includers = graph->includersOf(path);
+    auto headers = graph->headersOf(path);
+    if (includers.isEmpty() && headers.isEmpty())
+        return;
+    auto showFiles = [this](const QStringList& files) {
+        ICodeModelProvider::FileReferenceList refs;
+        for (const auto& f: files)
+            refs.append(ICodeModelProvider::FileReference(f, 1, 0, QFileInfo(f).fileName()));
+        FileReferencesDialog d(refs, this);
+        connect(&d, &FileReferencesDialog::itemClicked, [this](const QString& path, int line) {
+            ui->documentContainer->openDocumentHere(path, line, 0);
+        });
+        d.exec();
+    };
+    menu->addSeparator();
+    if (!includers.isEmpty()) {
+        auto text = tr("Included by %1 files, %2 objects to rebuild...")
+                .arg(includers.size()).arg(graph->rebuildImpact(path));
+        menu->addAction(text, [showFiles, includers]() { showFiles(includers); });
+    }
+    if (!headers.isEmpty())
+        menu->addAction(tr("Includes %1 headers...").arg(headers.size()), [showFiles, headers]() { showFiles(headers); });
+}
+
+void MainWindow::updateBuildQueue()
+{
+    // In the order of BuildManager::State
+    const QStringList stateNames{ tr("Queued"), tr("Running"), tr("Succeeded"), tr("Failed"), tr("Canceled") };
+    ui->queueView->clear();
+    for (const auto& e: priv->buildManager->entries()) {
+        QStringList after;
+        for (auto id: e.after)
+            after.append(QString("#%1").arg(id));
+        auto duration = e.started.isValid()? e.started.msecsTo(e.finished.isValid()? e.finished : QDateTime::currentDateTime()) : 0;
+        auto item = new QTreeWidgetItem(ui->queueView, {
+            QString("#%1 %2").arg(e.id).arg(e.target),
+            e.state == BuildManager::State::Failed? tr("Failed (%1)").arg(e.exitCode) : stateNames.at(int(e.state)),
+            after.join(' '),
+            e.jobs > 0? QString::number(e.jobs) : e.state == BuildManager::State::Running? tr("shared") : QString(),
+            e.started.isValid()? QString("%1 s").arg(duration / 1000.0, 0, 'f', 1) : QString(),
+        });
+        item->setData(0, Qt::UserRole, e.id);
+        item->setData(1, Qt::UserRole, priv->queueLogs.value(e.id));
+    }
+}
+
 void MainWindow::openProject(const QString &path)
 {
     priv->projectManager->openProject(path);
 }
 
+void MainWindow::saveSession()
+{
+    if (priv->sessionProject.isEmpty())
+        return;
+    QSaveFile f(sessionFilePath(priv->sessionProject));
+    if (f.open(QFile::WriteOnly)) {
+        f.write(QJsonDocument(ui->documentContainer->saveSession()).toJson());
+        f.commit();
+    }
+}
+
+void MainWindow::recoverJournals()
+{
+    // Journals left behind belong to editors that never closed: the IDE crashed
+    QHash<QString, EditJournal::Recovery> recovered;
+    for(const auto& journal: EditJournal::pendingJournals()) {
+        auto r = EditJournal::replay(journal);
+        if (r.valid) {
+            recovered.insert(journal, r);
+        } else {
+            priv->console->writeMessage(tr("Unsaved changes discarded: %1").arg(r.errorString), Qt::red);
+            QFile::remove(journal);
+        }
+    }
+    if (recovered.isEmpty())
+        return;
+    QStringList files;
+    for(const auto& r: recovered)
+        files.append(r.path);
+    QMessageBox messageBox(QMessageBox::Question,
+                           tr("Recover Unsaved Changes"),
+                           tr("The previous session ended with unsaved changes in:\n%1\n\nApply them to the files?")
+                                .arg(files.join('\n')),
+                           QMessageBox::Yes | QMessageBox::No,
+                           this);
+    messageBox.setButtonText(QMessageBox::Yes, tr("Yes"));
+    messageBox.setButtonText(QMessageBox::No, tr("No"));
+    bool apply = messageBox.exec() == QMessageBox::Yes;
+    for(auto it = recovered.cbegin(); it != recovered.cend(); ++it) {
+        if (apply) {
+            DocumentBuffer buffer;
+            buffer.path = it.value().path;
+            buffer.bytes = it.value().text;
+            auto error = DocumentIO::write(buffer);
+            if (!error.isEmpty()) {
+                priv->console->writeMessage(tr("Cannot recover %1: %2").arg(buffer.path, error), Qt::red);
+                continue;
+            }
+            priv->console->writeMessage(tr("Recovered %1").arg(buffer.path), Qt::darkGreen);
+        }
+        QFile::remove(it.key());
+    }
+}
+
 void MainWindow::closeEvent(QCloseEvent *event)
 {
+    saveSession();
     auto unsaved = ui->documentContainer->unsavedDocuments();
     if (unsaved.isEmpty()) {
         event->accept();
@@ -634,4 +1014,101 @@ void MainWindow::closeEvent(QCloseEvent *event)
         if (event->isAccepted())
             ui->documentContainer->saveDocuments(d.checkedForSave());
     }
+    if (event->isAccepted())
+        DocumentIO::waitForWrites();
+}
+
+void MainWindow::populateBuildHistory(QMenu *menu)
+{
+    menu->clear();
+    auto projectFile = priv->projectManager->projectFile();
+    auto builds = projectFile.isEmpty()? QList<BuildLogInfo>() : BuildLogStore::builds(projectFile);
+    if (builds.isEmpty()) {
+        menu->addAction(tr("No builds recorded"))->setEnabled(false);
+        return;
+    }
+    for (int i = 0; i < builds.size(); i++) {
+        const auto log = builds.at(i);
+        auto status = !log.finished.isValid()? tr("incomplete") :
+                      log.exitCode == 0? tr("ok") : tr("failed (%1)").arg(log.exitCode);
+        auto sub = menu->addMenu(tr("%1 %2 [%3, %4 lines]")
+                                 .arg(log.started.toString(Qt::SystemLocaleShortDate), log.target, status)
+                                 .arg(log.lineCount));
+        // Large logs open in the memory mapped viewer, paging is free
+        sub->addAction(tr("Open Log"), [this, log]() {
+            ui->documentContainer->openDocumentHere(log.logPath(), 1, 0);
+            ui->documentContainer->setFocus();
+        });
+        sub->addAction(tr("Search..."), [this, log]() { searchBuildLog(log); });
+        if (i + 1 < builds.size()) {
+            const auto previous = builds.at(i + 1);
+            sub->addAction(tr("Compare Warnings With Previous Build"), [this, previous, log]() {
+                compareBuildWarnings(previous, log);
+            });
+        }
+    }
+}
+
+void MainWindow::showMessageStatistics()
+{
+    ui->logTabs->setCurrentWidget(ui->consoleTab);
+    priv->console->writeMessage(tr("Message topics:\n"), Qt::darkGreen);
+    for (const auto& s: TextMessageBrocker::instance().statistics())
+        priv->console->writeMessage(tr("  %1: %2 subscribers, %3 published, %4 delivered, %5/s\n")
+                                    .arg(s.name).arg(s.subscribers).arg(s.published).arg(s.delivered)
+                                    .arg(s.rate, 0, 'f', 1));
+}
+
+void MainWindow::searchBuildLog(const BuildLogInfo &log)
+{
+    bool ok = false;
+    auto pattern = QInputDialog::getText(this, tr("Search Build Log"), tr("Regular expression:"),
+                                         QLineEdit::Normal, QString(), &ok);
+    if (!ok || pattern.isEmpty())
+        return;
+    QRegularExpression re(pattern);
+    if (!re.isValid()) {
+        priv->console->writeMessage(tr("Invalid expression: %1\n").arg(re.errorString()), Qt::red);
+        return;
+    }
+    ui->logTabs->setCurrentWidget(ui->consoleTab);
+    priv->console->writeMessage(tr("Searching \"%1\" in %2...\n").arg(pattern, log.logPath()), Qt::darkGreen);
+    auto watcher = new QFutureWatcher<QVector<BuildLogMatch>>(this);
+    connect(watcher, &QFutureWatcher<QVector<BuildLogMatch>>::finished, this, [this, watcher, log]() {
+        watcher->deleteLater();
+        auto matches = watcher->result();
+        QTextCharFormat linkFmt;
+        linkFmt.setAnchor(true);
+        linkFmt.setForeground(ui->logView->palette().link().color());
+        for (const auto& m: matches) {
+            linkFmt.setAnchorHref(ICodeModelProvider::FileReference(log.logPath(), m.line + 1, 0, m.text).encode().toString());
+            ConsoleInterceptor::writeMessageTo(ui->logView, QString("%1: ").arg(m.line + 1), linkFmt);
+            ConsoleInterceptor::writeMessageTo(ui->logView, m.text + '\n');
+        }
+        priv->console->writeMessage(tr("%1 matches\n").arg(matches.size()), Qt::darkGreen);
+    });
+    watcher->setFuture(BuildLogStore::search(log, re));
+}
+
+void MainWindow::compareBuildWarnings(const BuildLogInfo &before, const BuildLogInfo &after)
+{
+    QVector<BuildDiagnostic> added, fixed;
+    BuildLogStore::diffWarnings(BuildLogStore::diagnostics(before), BuildLogStore::diagnostics(after), &added, &fixed);
+    ui->logTabs->setCurrentWidget(ui->consoleTab);
+    auto writeList = [this](const QString& title, const QVector<BuildDiagnostic>& list, const QColor& color) {
+        priv->console->writeMessage(title.arg(list.size()), color);
+        QTextCharFormat linkFmt;
+        linkFmt.setAnchor(true);
+        linkFmt.setForeground(ui->logView->palette().link().color());
+        for (const auto& d: list) {
+            linkFmt.setAnchorHref(ICodeModelProvider::FileReference(d.file, d.line, qMax(0, d.column), d.message).encode().toString());
+            ConsoleInterceptor::writeMessageTo(ui->logView, QString("%1:%2: ").arg(d.file).arg(d.line), linkFmt);
+            ConsoleInterceptor::writeMessageTo(ui->logView, d.message + '\n');
+        }
+    };
+    priv->console->writeMessage(tr("Warnings of %1 compared with %2\n")
+                                .arg(after.started.toString(Qt::SystemLocaleShortDate),
+                                     before.started.toString(Qt::SystemLocaleShortDate)), Qt::darkGreen);
+    writeList(tr("%1 new warnings\n"), added, Qt::darkYellow);
+    writeList(tr("%1 fixed warnings\n"), fixed, Qt::darkGreen);
 }
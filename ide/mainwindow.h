@@ -27,6 +27,11 @@ namespace Ui {
 class MainWindow;
 }
 
+class QMenu;
+class BuildOutputParser;
+struct BuildLogInfo;
+struct BuildOutputBatch;
+
 class MainWindow : public QWidget
 {
     Q_OBJECT
@@ -42,6 +47,19 @@ protected:
     void closeEvent(QCloseEvent *event) override;
 
 private:
+    void saveSession();
+    void recoverJournals();
+    void populateBuildHistory(QMenu *menu);
+    void searchBuildLog(const BuildLogInfo& log);
+    void compareBuildWarnings(const BuildLogInfo& before, const BuildLogInfo& after);
+    BuildOutputParser *createBuildParser(int id);
+    void renderBuildBatch(const BuildOutputBatch& batch);
+    void updateBuildQueue();
+    void compileCurrentFile();
+    void refreshIncludeGraph();
+    void addIncludeGraphActions(QMenu *menu, const QString& path);
+    void showMessageStatistics();
+
     class Priv_t;
 
     std::unique_ptr<Ui::MainWindow> ui;
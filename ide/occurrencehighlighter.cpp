@@ -0,0 +1,135 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "occurrencehighlighter.h"
+
+#include <Qsci/qsciscintilla.h>
+
+#include <QElapsedTimer>
+
+static constexpr int DEBOUNCE_MS = 150;
+static constexpr int SLICE_BUDGET_MS = 4;
+static constexpr int MAX_PATTERN_LENGTH = 256;
+// Very frequent words: the visible range is always complete, the rest stop here
+static constexpr int MAX_MATCHES = 2000;
+
+OccurrenceHighlighter::OccurrenceHighlighter(QsciScintilla *editor, int indicator) :
+    QObject(editor),
+    editor(editor),
+    indicator(indicator)
+{
+    debounceTimer.setSingleShot(true);
+    debounceTimer.setInterval(DEBOUNCE_MS);
+    sliceTimer.setSingleShot(true);
+    sliceTimer.setInterval(0);
+    connect(&debounceTimer, &QTimer::timeout, this, &OccurrenceHighlighter::startSearch);
+    connect(&sliceTimer, &QTimer::timeout, this, &OccurrenceHighlighter::searchNextSlice);
+    connect(editor, &QsciScintilla::selectionChanged, this, &OccurrenceHighlighter::restart);
+    connect(editor, &QsciScintilla::textChanged, this, &OccurrenceHighlighter::restart);
+}
+
+OccurrenceHighlighter::~OccurrenceHighlighter()
+= default;
+
+void OccurrenceHighlighter::restart()
+{
+    cancel();
+    clearIndicator();
+    debounceTimer.start();
+}
+
+void OccurrenceHighlighter::cancel()
+{
+    debounceTimer.stop();
+    sliceTimer.stop();
+    pattern.clear();
+}
+
+void OccurrenceHighlighter::startSearch()
+{
+    auto word = editor->selectedText();
+    if (word.isEmpty() || word.length() > MAX_PATTERN_LENGTH || word.contains('\n'))
+        return;
+    pattern = editor->isUtf8()? word.toUtf8() : word.toLatin1();
+    matchCount = 0;
+
+    auto firstLine = editor->SendScintilla(QsciScintilla::SCI_DOCLINEFROMVISIBLE,
+                                           editor->SendScintilla(QsciScintilla::SCI_GETFIRSTVISIBLELINE));
+    auto lastLine = firstLine + editor->SendScintilla(QsciScintilla::SCI_LINESONSCREEN);
+    visibleStart = editor->SendScintilla(QsciScintilla::SCI_POSITIONFROMLINE, firstLine);
+    visibleEnd = editor->SendScintilla(QsciScintilla::SCI_GETLINEENDPOSITION, lastLine);
+
+    searchRange(visibleStart, visibleEnd, false);
+
+    // Rest of the document from the end of the viewport, wrapping around
+    position = visibleEnd;
+    wrapped = false;
+    sliceTimer.start();
+}
+
+void OccurrenceHighlighter::searchNextSlice()
+{
+    if (pattern.isEmpty())
+        return;
+    auto length = editor->SendScintilla(QsciScintilla::SCI_GETLENGTH);
+    bool done = wrapped?
+                searchRange(position, visibleStart, true) :
+                searchRange(position, length, true);
+    if (done && !wrapped) {
+        wrapped = true;
+        position = 0;
+        done = false;
+    }
+    if (!done && matchCount < MAX_MATCHES)
+        sliceTimer.start();
+}
+
+bool OccurrenceHighlighter::searchRange(long from, long to, bool timeBound)
+{
+    QElapsedTimer budget;
+    budget.start();
+    editor->SendScintilla(QsciScintilla::SCI_SETINDICATORCURRENT, indicator);
+    editor->SendScintilla(QsciScintilla::SCI_SETSEARCHFLAGS, QsciScintilla::SCFIND_WHOLEWORD);
+    while (from < to) {
+        if (timeBound && (budget.elapsed() >= SLICE_BUDGET_MS || matchCount >= MAX_MATCHES)) {
+            position = from;
+            return false;
+        }
+        editor->SendScintilla(QsciScintilla::SCI_SETTARGETSTART, from);
+        editor->SendScintilla(QsciScintilla::SCI_SETTARGETEND, to);
+        auto pos = editor->SendScintilla(QsciScintilla::SCI_SEARCHINTARGET,
+                                         static_cast<unsigned long>(pattern.length()),
+                                         pattern.constData());
+        if (pos == -1)
+            break;
+        auto end = editor->SendScintilla(QsciScintilla::SCI_GETTARGETEND);
+        editor->SendScintilla(QsciScintilla::SCI_INDICATORFILLRANGE,
+                              static_cast<unsigned long>(pos), end - pos);
+        matchCount++;
+        from = qMax(end, pos + 1);
+    }
+    position = to;
+    return true;
+}
+
+void OccurrenceHighlighter::clearIndicator()
+{
+    editor->SendScintilla(QsciScintilla::SCI_SETINDICATORCURRENT, indicator);
+    editor->SendScintilla(QsciScintilla::SCI_INDICATORCLEARRANGE, 0,
+                          editor->SendScintilla(QsciScintilla::SCI_GETLENGTH));
+}
@@ -0,0 +1,59 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef OCCURRENCEHIGHLIGHTER_H
+#define OCCURRENCEHIGHLIGHTER_H
+
+#include <QObject>
+#include <QTimer>
+
+class QsciScintilla;
+
+class OccurrenceHighlighter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit OccurrenceHighlighter(QsciScintilla *editor, int indicator);
+    ~OccurrenceHighlighter() override;
+
+public slots:
+    void restart();
+    void cancel();
+
+private slots:
+    void startSearch();
+    void searchNextSlice();
+
+private:
+    bool searchRange(long from, long to, bool timeBound);
+    void clearIndicator();
+
+    QsciScintilla *editor;
+    int indicator;
+    QTimer debounceTimer;
+    QTimer sliceTimer;
+
+    QByteArray pattern;
+    long visibleStart = 0;
+    long visibleEnd = 0;
+    long position = 0;
+    bool wrapped = false;
+    int matchCount = 0;
+};
+
+#endif // OCCURRENCEHIGHLIGHTER_H
@@ -17,7 +17,11 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 #include "appconfig.h"
+#include "documentio.h"
+#include "editjournal.h"
 #include "formfindreplace.h"
+#include "linediff.h"
+#include "occurrencehighlighter.h"
 #include "plaintexteditor.h"
 #include "textmessagebrocker.h"
 
@@ -26,11 +30,13 @@
 #include <Qsci/qscilexer.h>
 
 #include <QFile>
+#include <QFutureWatcher>
 #include <QMenu>
 #include <QMessageBox>
 #include <QRegularExpression>
 #include <QtDebug>
 #include <QCloseEvent>
+#include <QtConcurrent>
 
 #include <cmath>
 
@@ -41,23 +47,13 @@ PlainTextEditor::PlainTextEditor(QWidget *parent) : QsciScintilla(parent)
     connect(this, &QsciScintilla::linesChanged, this, &PlainTextEditor::adjustLineNumberMargin);
     connect(this, &QsciScintilla::cursorPositionChanged,
             [this](int line, int col) { notifyCursorOvserver(line + 1, col + 1); });
-    connect(this, &QsciScintilla::selectionChanged, [this](){
-        auto editorLength = SendScintilla(SCI_GETLENGTH);
-        SendScintilla(SCI_SETINDICATORCURRENT, 0);
-        SendScintilla(SCI_INDICATORCLEARRANGE, 0, editorLength);
-        auto word = selectedText();
-        if (!word.isEmpty()) {
-            int endpos = 0;
-            auto startpos = 0;
-            startpos = findText(word, SCFIND_WHOLEWORD, startpos, &endpos);
-            while(startpos != -1) {
-                SendScintilla(SCI_INDICATORFILLRANGE,
-                              static_cast<unsigned long>(startpos),
-                              endpos - startpos);
-                startpos = findText(word, SCFIND_WHOLEWORD, endpos + 1, &endpos);
-            }
-        }
+    connect(this, &QsciScintillaBase::SCN_MODIFIED, [this](int position, int type) {
+        Q_UNUSED(position)
+        if (type & (SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT))
+            textRevision++;
     });
+    occurrences = new OccurrenceHighlighter(this, 0);
+    journal = new EditJournal(this);
     connect(this, &PlainTextEditor::modificationChanged, [this]() {
         notifyModifyObservers();
     });
@@ -76,7 +72,7 @@ PlainTextEditor::PlainTextEditor(QWidget *parent) : QsciScintilla(parent)
     auto findDialog = new FormFindReplace(this);
     findDialog->hide();
 
-    TextMessageBrocker::instance().subscribe(TextMessages::DEBUG_IP_CHANGE,
+    TextMessageBrocker::instance().subscribe(TextMessages::DEBUG_IP_CHANGE, this,
                                              [this](const QString& msg) {
         QRegularExpression re(R"((.+?)\:(\d+))");
         auto m = re.match(msg);
@@ -98,166 +94,126 @@ PlainTextEditor::PlainTextEditor(QWidget *parent) : QsciScintilla(parent)
         connect(acc, &QAction::triggered, functor);
         addAction(acc);
     };
-    mkAction("ctrl+s", [this]() { save(path()); });
-    mkAction("ctrl+r", [this]() { load(path()); });
+    mkAction("ctrl+s", [this]() {
+        if (documentManager())
+            documentManager()->saveDocument(path());
+        else
+            save(path());
+    });
+    mkAction("ctrl+r", [this]() { reload(); });
     mkAction("ctrl+space", [this]() { triggerAutocompletion(); });
     mkAction("ctrl+f", [findDialog]() { findDialog->show(); });
 }
 
 PlainTextEditor::~PlainTextEditor() = default;
 
-// NPP detect indent from nppIndenture writed by Evan King
-// https://github.com/evan-king/nppIndenture
-// Licenced by GPL-3.0
-namespace npp_detectident {
-
-constexpr auto MIN_INDENT = 2; // minimum width of a single indentation
-constexpr auto MAX_INDENT = 8; // maximum width of a single indentation
-
-constexpr auto MIN_DEPTH = MIN_INDENT; // ignore lines below this indentation level
-constexpr auto MAX_DEPTH = 3*MAX_INDENT; // ignore lines beyond this indentation level
-
-// % of lines allowed to contradict indentation option without penalty
-constexpr auto GRACE_FREQUENCY = 1 / 50.0F;
-
-struct ParseResult {
-    int num_tab_lines = 0;
-    int num_space_lines = 0;
-    float grace = 0.0F;
-
-    // indentation => count(lines of that exact indentation)
-    std::array<int, MAX_DEPTH+1> depth_counts = { { 0 } };
-};
-
-ParseResult parseDocument(QsciScintilla *doc) {
-    ParseResult result;
-
-    const int num_lines = doc->lines();
-    result.grace = float(num_lines) * GRACE_FREQUENCY;
-    for(int i = 0; i < num_lines; ++i) {
-        const auto depth = static_cast<decltype (result.depth_counts)::size_type>(doc->indentation(i));
-        if(depth < MIN_DEPTH || depth > MAX_DEPTH)
-            continue;
-
-        auto pos = doc->SendScintilla(QsciScintilla::SCI_POSITIONFROMLINE, i);
-        auto lineHeadChar = doc->SendScintilla(QsciScintilla::SCI_GETCHARAT, pos);
-
-        if(lineHeadChar == '\t') result.num_tab_lines++;
-
-        if(lineHeadChar == ' ') {
-            result.num_space_lines++;
-            result.depth_counts.at(depth)++;
-        }
-    }
-
-    return result;
+bool PlainTextEditor::load(const QString &path)
+{
+    return attach(DocumentIO::read(path, AppConfig::instance().editorTabWidth()));
 }
 
-struct IndentInfo {
-    enum class IndentType { Invalid, Space, Tab };
-
-    IndentType type = IndentType::Invalid;
-    int num = 0;
-};
-
-IndentInfo detectIndentInfo(QsciScintilla *doc) {
-
-    const ParseResult result = parseDocument(doc);
-    IndentInfo info;
-
-    // decide `type`
-    if(result.num_tab_lines + result.num_space_lines == 0)
-        info.type = IndentInfo::IndentType::Invalid;
-    else if(result.num_space_lines > (result.num_tab_lines * 4))
-        info.type = IndentInfo::IndentType::Space;
-    else if(result.num_tab_lines > (result.num_space_lines * 4))
-        info.type = IndentInfo::IndentType::Tab;
-    /*else
-        {
-            const auto sci = plugin.getSciCallFunctor();
-            const bool useTab = sci.call<bool>(SCI_GETUSETABS);
-            info.type = useTab ? IndentType::Tab : IndentType::Space;
-        }*/
-
-    // decide `num`
-    if(info.type == IndentInfo::IndentType::Space) {
-
-        // indent size => count(space-indented lines with incompatible indentation)
-        std::array<int, MAX_INDENT+1> margins = {0};
-        using margins_size = decltype (margins)::size_type;
-
-        // for each depth option, count the incompatible lines
-        for(margins_size i = MIN_DEPTH; i <= MAX_DEPTH; i++) {
-            for(margins_size k = MIN_INDENT; k <= MAX_INDENT; k++) {
-                if(i % k == 0)
-                    continue;
-                margins.at(k) += result.depth_counts.at(i);
-            }
-        }
-
-        // choose the last indent with the smallest margin (ties go to larger indent)
-        // Considers margins within grace of zero as =zero,
-        // so occasional typos don't force smaller indentation
-        margins_size which = MIN_INDENT;
-        for(margins_size i = MIN_INDENT; i <= MAX_INDENT; ++i) {
-            if(result.depth_counts.at(i) == 0) continue;
-            if(margins.at(i) <= margins.at(which) || margins.at(i) < result.grace) which = i;
+bool PlainTextEditor::attach(const DocumentBuffer &buffer)
+{
+    if (!buffer.valid)
+        return false;
+    bool ro = isReadOnly();
+    setReadOnly(false);
+    if (journal)
+        journal->setRecording(false);
+    SendScintilla(SCI_CLEARALL);
+    SendScintilla(SCI_APPENDTEXT, static_cast<unsigned long>(buffer.bytes.size()), buffer.bytes.constData());
+    SendScintilla(SCI_EMPTYUNDOBUFFER);
+    if (journal)
+        journal->setRecording(true);
+    setReadOnly(ro);
+    setPath(buffer.path);
+    loadConfig();
+    if (AppConfig::instance().editorDetectIdent()) {
+        const auto& info = buffer.indent;
+        if (info.type == IndentInfo::IndentType::Tab) {
+            setIndentationsUseTabs(true);
+        } else if (info.type == IndentInfo::IndentType::Space) {
+            setIndentationsUseTabs(false);
+            setIndentationWidth(info.num);
+        } else {
+            // Nothing to do... fallback to config
         }
-
-        info.num = static_cast<int>(which);
     }
-
-    return info;
+    return true;
 }
 
+bool PlainTextEditor::attachView(IDocumentEditor *source)
+{
+    auto other = dynamic_cast<PlainTextEditor*>(source);
+    if (!other)
+        return false;
+    // Text, undo history, styling, indicators and markers are owned by the shared document,
+    // the source editor already journals it and highlights occurrences and the debugger line
+    delete journal;
+    journal = nullptr;
+    delete occurrences;
+    occurrences = nullptr;
+    TextMessageBrocker::instance().unsubscribeAll(this);
+    setDocument(other->document());
+    setReadOnly(other->isReadOnly());
+    setPath(other->path());
+    loadConfig();
+    setIndentationsUseTabs(other->indentationsUseTabs());
+    setIndentationWidth(other->indentationWidth());
+    return true;
 }
 
-bool PlainTextEditor::load(const QString &path)
+DocumentBuffer PlainTextEditor::snapshot() const
 {
-    QFile f(path);
-    if (f.open(QFile::ReadOnly)) {
-        if (read(&f)) {
-            setPath(path);
-            loadConfig();
-            if (AppConfig::instance().editorDetectIdent()) {
-                auto info = npp_detectident::detectIndentInfo(this);
-                if (info.type == npp_detectident::IndentInfo::IndentInfo::IndentType::Tab) {
-                    setIndentationsUseTabs(true);
-                } else if (info.type == npp_detectident::IndentInfo::IndentInfo::IndentType::Space) {
-                    setIndentationsUseTabs(false);
-                    setIndentationWidth(info.num);
-                } else {
-                    // Nothing to do... fallback to config
-                }
-            }
-            return true;
-        }
-    }
-    return false;
+    DocumentBuffer buffer;
+    buffer.path = path();
+    buffer.bytes = textRange(0, static_cast<int>(SendScintilla(SCI_GETLENGTH)));
+    buffer.valid = true;
+    return buffer;
 }
 
 bool PlainTextEditor::save(const QString &path)
 {
-    QFile f(path);
-    if (f.open(QFile::WriteOnly)) {
-        if (write(&f)) {
-            setPath(path);
-            setModified(false);
-            return true;
-        }
+    auto buffer = snapshot();
+    buffer.path = path;
+    auto error = DocumentIO::write(buffer);
+    if (!error.isEmpty()) {
+        TextMessageBrocker::instance().publish(TextMessages::STDERR_LOG,
+                                               tr("Cannot save %1: %2").arg(path, error));
+        return false;
     }
-    return false;
+    setPath(path);
+    setModified(false);
+    return true;
 }
 
+struct ReloadChange {
+    DocumentBuffer buffer;
+    QVector<TextEdit> edits;
+};
+
 void PlainTextEditor::reload()
 {
-    QFile f(path());
-    if (f.open(QFile::ReadOnly)) {
-        auto c = cursor();
-        read(&f);
-        setCursor(c);
-        setModified(false);
-    }
+    // Read and diff in background, the buffer only receives the changed lines
+    auto before = snapshot();
+    auto tabWidth = AppConfig::instance().editorTabWidth();
+    auto watcher = new QFutureWatcher<ReloadChange>(this);
+    connect(watcher, &QFutureWatcher<ReloadChange>::finished, this, [this, watcher, before]() {
+        watcher->deleteLater();
+        auto change = watcher->result();
+        if (!change.buffer.valid)
+            return;
+        if (snapshot().bytes != before.bytes)
+            return; // Edited meanwhile, keep the user changes
+        applyReload(change.edits);
+    });
+    watcher->setFuture(QtConcurrent::run(DocumentIO::pool(), [before, tabWidth]() {
+        ReloadChange change;
+        change.buffer = DocumentIO::read(before.path, tabWidth);
+        if (change.buffer.valid)
+            change.edits = LineDiff::edits(before.bytes, change.buffer.bytes);
+        return change;
+    }));
 }
 
 bool PlainTextEditor::isReadonly() const
@@ -272,12 +228,19 @@ void PlainTextEditor::setReadonly(bool rdOnly)
 
 bool PlainTextEditor::isModified() const
 {
-    return QsciScintilla::isModified();
+    return forcedModified || QsciScintilla::isModified();
 }
 
 void PlainTextEditor::setModified(bool m)
 {
+    // Scintilla can only clear its flag, a failed write keeps the document dirty here
+    bool was = isModified();
+    bool scintillaWas = QsciScintilla::isModified();
+    forcedModified = m;
     QsciScintilla::setModified(m);
+    // Observers are already notified when the Scintilla flag itself changed
+    if (was != isModified() && scintillaWas == QsciScintilla::isModified())
+        notifyModifyObservers();
 }
 
 QPoint PlainTextEditor::cursor() const
@@ -293,6 +256,34 @@ void PlainTextEditor::setCursor(const QPoint &pos)
     setCursorPosition(pos.y() - 1, pos.x());
 }
 
+QVariantMap PlainTextEditor::saveState() const
+{
+    int line;
+    int col;
+    getCursorPosition(&line, &col);
+    QVariantList folds;
+    for(int l: contractedFolds())
+        folds.append(l);
+    return {
+        { "line", line },
+        { "col", col },
+        { "firstVisibleLine", firstVisibleLine() },
+        { "folds", folds },
+    };
+}
+
+void PlainTextEditor::restoreState(const QVariantMap &state)
+{
+    if (state.isEmpty())
+        return;
+    QList<int> folds;
+    for(const auto& l: state.value("folds").toList())
+        folds.append(l.toInt());
+    setContractedFolds(folds);
+    setCursorPosition(state.value("line").toInt(), state.value("col").toInt());
+    setFirstVisibleLine(state.value("firstVisibleLine").toInt());
+}
+
 class PlainTextEditorCreator: public IDocumentEditorCreator
 {
 public:
@@ -338,6 +329,45 @@ void PlainTextEditor::adjustLineNumberMargin()
 #endif
 }
 
+QByteArray PlainTextEditor::textRange(int start, int end) const
+{
+    end = qMin(end, static_cast<int>(SendScintilla(SCI_GETLENGTH)));
+    if (end <= start)
+        return QByteArray();
+    QByteArray buffer(end - start + 1, '\0');
+    SendScintilla(SCI_GETTEXTRANGE, start, end, buffer.data());
+    buffer.chop(1);
+    return buffer;
+}
+
+void PlainTextEditor::applyTextEdits(int position, const QVector<TextEdit> &edits)
+{
+    if (edits.isEmpty())
+        return;
+    // Bottom-up keeps the offsets of the pending edits valid
+    SendScintilla(SCI_BEGINUNDOACTION);
+    for(auto it = edits.crbegin(); it != edits.crend(); ++it) {
+        SendScintilla(SCI_SETTARGETSTART, position + it->start);
+        SendScintilla(SCI_SETTARGETEND, position + it->start + it->length);
+        SendScintilla(SCI_REPLACETARGET, static_cast<unsigned long>(it->text.size()), it->text.constData());
+    }
+    SendScintilla(SCI_ENDUNDOACTION);
+}
+
+void PlainTextEditor::applyReload(const QVector<TextEdit> &edits)
+{
+    // Only changed lines are replaced, undo history, folds and cursor survive the reload
+    bool ro = isReadOnly();
+    setReadOnly(false);
+    if (journal)
+        journal->setRecording(false);
+    applyTextEdits(0, edits);
+    if (journal)
+        journal->setRecording(true);
+    setReadOnly(ro);
+    setModified(false);
+}
+
 int PlainTextEditor::findText(const QString &text, int flags, int start, int *targend)
 {
     ScintillaBytes s = textAsBytes(text);
@@ -22,6 +22,12 @@
 #include <idocumenteditor.h>
 #include <Qsci/qsciscintilla.h>
 
+#include <QVector>
+
+struct TextEdit;
+class EditJournal;
+class OccurrenceHighlighter;
+
 class PlainTextEditor : public IDocumentEditor, public QsciScintilla
 {
 public:
@@ -31,6 +37,12 @@ public:
     const QWidget *widget() const override { return this; }
     QWidget *widget() override { return this; }
     bool load(const QString &path) override;
+    bool canAttach() const override { return true; }
+    bool attach(const DocumentBuffer& buffer) override;
+    bool attachView(IDocumentEditor *source) override;
+    bool canSnapshot() const override { return true; }
+    DocumentBuffer snapshot() const override;
+    quint64 revision() const override { return textRevision; }
     bool save(const QString &path) override;
     void reload() override;
     virtual bool isReadonly() const override;
@@ -39,12 +51,18 @@ public:
     void setModified(bool m) override;
     QPoint cursor() const override;
     void setCursor(const QPoint &pos) override;
+    QVariantMap saveState() const override;
+    void restoreState(const QVariantMap& state) override;
 
     static IDocumentEditorCreator *creator();
 
     QString wordUnderCursor() const;
     QString lineUnderCursor() const;
 
+    QByteArray textRange(int start, int end) const;
+    void applyTextEdits(int position, const QVector<TextEdit>& edits);
+    void applyReload(const QVector<TextEdit>& edits);
+
     virtual void triggerAutocompletion();
 
 public slots:
@@ -63,6 +81,12 @@ protected:
     QStringList allWords();
 
     virtual QMenu *createContextualMenu();
+
+private:
+    bool forcedModified = false;
+    quint64 textRevision = 0;
+    EditJournal *journal = nullptr; // Null on split views, the source editor journals the document
+    OccurrenceHighlighter *occurrences = nullptr;
 };
 
 #endif // PLAINTEXTEDITOR_H
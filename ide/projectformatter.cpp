@@ -0,0 +1,158 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "projectformatter.h"
+#include "appconfig.h"
+#include "cpptexteditor.h"
+#include "sourceformatter.h"
+
+#include <QCryptographicHash>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QtConcurrent>
+
+static const QString CACHE_FILE = "formatcache.json";
+
+namespace {
+
+struct FileResult {
+    QString path;
+    QByteArray hash; // Of the formatted content and options
+    bool touched = false;
+    QStringList errors;
+};
+
+QByteArray stateHash(const QByteArray& content, const QByteArray& options)
+{
+    QCryptographicHash h(QCryptographicHash::Sha1);
+    h.addData(options);
+    h.addData(content);
+    return h.result().toHex();
+}
+
+QString cacheFilePath()
+{
+    return QDir(AppConfig::instance().workspacePath()).filePath(CACHE_FILE);
+}
+
+}
+
+class ProjectFormatter::Priv_t {
+public:
+    QFutureWatcher<FileResult> watcher;
+    QElapsedTimer elapsed;
+    QJsonObject cache;
+};
+
+ProjectFormatter::ProjectFormatter(QObject *parent) :
+    QObject(parent),
+    priv(std::make_unique<Priv_t>())
+{
+    connect(&priv->watcher, &QFutureWatcher<FileResult>::finished, this, [this]() {
+        QStringList touched;
+        const auto results = priv->watcher.future().results();
+        for(const auto& r: results) {
+            for(const auto& e: r.errors)
+                emit errorMessage(tr("%1: %2").arg(r.path, e));
+            if (!r.hash.isEmpty())
+                priv->cache.insert(r.path, QString(r.hash));
+            if (r.touched)
+                touched.append(r.path);
+        }
+        QSaveFile f(cacheFilePath());
+        if (f.open(QFile::WriteOnly)) {
+            f.write(QJsonDocument(priv->cache).toJson());
+            f.commit();
+        }
+        emit finished(touched, results.count(), priv->elapsed.elapsed());
+    });
+}
+
+ProjectFormatter::~ProjectFormatter()
+{
+    priv->watcher.cancel();
+    priv->watcher.waitForFinished();
+}
+
+bool ProjectFormatter::isRunning() const
+{
+    return priv->watcher.isRunning();
+}
+
+void ProjectFormatter::start(const QString &projectPath, const QStringList &excluded)
+{
+    if (isRunning() || projectPath.isEmpty())
+        return;
+    priv->elapsed.start();
+
+    QStringList files;
+    QStringList filters;
+    for(const auto& ext: CPPTextEditor::sourceExtensions())
+        filters.append(QString("*.%1").arg(ext));
+    QDirIterator it(projectPath, filters, QDir::Files | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        auto path = it.next();
+        if (!excluded.contains(path) && !path.contains("/."))
+            files.append(path);
+    }
+
+    QFile cacheFile(cacheFilePath());
+    if (cacheFile.open(QFile::ReadOnly))
+        priv->cache = QJsonDocument::fromJson(cacheFile.readAll()).object();
+    const auto cache = priv->cache;
+    const auto formatter = SourceFormatter::fromConfig();
+
+    emit started(files.count());
+    priv->watcher.setFuture(QtConcurrent::mapped(files, std::function<FileResult(const QString&)>(
+        [formatter, cache](const QString& path) {
+        FileResult r;
+        r.path = path;
+        QFile f(path);
+        if (!f.open(QFile::ReadOnly)) {
+            r.errors.append(f.errorString());
+            return r;
+        }
+        auto content = f.readAll();
+        f.close();
+        auto hash = stateHash(content, formatter.options());
+        if (cache.value(path).toString().toLatin1() == hash) {
+            r.hash = hash;
+            return r;
+        }
+        auto result = formatter.format(content);
+        r.errors = result.errors;
+        if (!result.valid)
+            return r;
+        if (result.text != content) {
+            QSaveFile out(path);
+            if (!out.open(QFile::WriteOnly) || out.write(result.text) != result.text.size() || !out.commit()) {
+                r.errors.append(out.errorString());
+                return r;
+            }
+            r.touched = true;
+        }
+        r.hash = stateHash(result.text, formatter.options());
+        return r;
+    })));
+}
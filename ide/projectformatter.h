@@ -0,0 +1,48 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef PROJECTFORMATTER_H
+#define PROJECTFORMATTER_H
+
+#include <QObject>
+
+#include <memory>
+
+class ProjectFormatter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ProjectFormatter(QObject *parent = nullptr);
+    ~ProjectFormatter() override;
+
+    bool isRunning() const;
+
+signals:
+    void started(int fileCount);
+    void finished(const QStringList& touched, int total, qint64 elapsedMillis);
+    void errorMessage(const QString& msg);
+
+public slots:
+    void start(const QString& projectPath, const QStringList& excluded = QStringList());
+
+private:
+    class Priv_t;
+    std::unique_ptr<Priv_t> priv;
+};
+
+#endif // PROJECTFORMATTER_H
@@ -23,7 +23,7 @@
 #include "icodemodelprovider.h"
 #include "processmanager.h"
 #include "projectmanager.h"
-#include "regexhtmltranslator.h"
+#include "ansitexttranslator.h"
 #include "textmessagebrocker.h"
 
 #include <QBuffer>
@@ -57,11 +57,18 @@ const QString EXPORT_PROC = "exporter";
 
 using targetMap_t = QHash<QString, QStringList>;
 
+struct MakeDatabase {
+    targetMap_t targets;
+    targetMap_t refs;
+    QString shell; // Only when the makefile sets it
+};
+
 class ProjectManager::Priv_t {
 public:
     QStringList targets;
     targetMap_t allTargets;
     targetMap_t allRefs;
+    QString makeShell;
     QRegularExpression targetFilter{ R"(^(?!Makefile)[a-zA-Z0-9_\\-]+$)", QRegularExpression::MultilineOption };
     QListView *targetView{ nullptr };
     ProcessManager *pman{ nullptr };
@@ -72,6 +79,7 @@ public:
     void doCloseProject() {
         allTargets.clear();
         targets.clear();
+        makeShell.clear();
 
         if (targetView->model())
             targetView->model()->deleteLater();
@@ -86,12 +94,22 @@ public:
     }
 };
 
-static QPair<targetMap_t, targetMap_t> findAllTargets(QIODevice *in)
+static MakeDatabase findAllTargets(QIODevice *in)
 {
-    QPair<targetMap_t, targetMap_t> map;
+    MakeDatabase map;
     QRegularExpression re(R"(^([^\#\s][^\%\=]*?):[^\=]\s*([^#\r\n]*?)\s*$)");
+    QRegularExpression shellRe(R"(^SHELL :?= ([^$\r\n]+?)\s*$)");
+    QByteArray origin;
     while (!in->atEnd()) {
         auto line = in->readLine();
+        // Variables are preceded by their origin, "# makefile (from 'Makefile', line 3)"
+        if (line.startsWith("SHELL ")) {
+            auto me = shellRe.match(line);
+            if (me.hasMatch() && origin.startsWith("# makefile"))
+                map.shell = me.captured(1);
+            continue;
+        }
+        origin = line;
         if (line.startsWith("# Not a target:")) {
             in->readLine();
             in->readLine();
@@ -102,9 +120,9 @@ static QPair<targetMap_t, targetMap_t> findAllTargets(QIODevice *in)
             auto tgt = me.captured(1);
             auto depsText = me.captured(2);
             auto deps = depsText.split(' ');
-            map.first[tgt].append(deps);
+            map.targets[tgt].append(deps);
             for(const auto& a: deps)
-                map.second[a].append(tgt);
+                map.refs[a].append(tgt);
         }
     }
     return map;
@@ -123,7 +141,7 @@ ProjectManager::ProjectManager(QListView *view, ProcessManager *pman, QObject *p
             button->setIcon(QIcon(AppConfig::resourceImage({ "actions", "run-build" })));
     });
 
-    TextMessageBrocker::instance().subscribe("findAndOpen", [this](const QString& path) {
+    TextMessageBrocker::instance().subscribe(TextMessages::FIND_AND_OPEN, this, [this](const QString& path) {
         auto files = FindAndOpenFileDialog::findFilesInPath(path, projectPath());
         if (files.length() == 1) {
             requestFileOpen(files.first());
@@ -141,7 +159,7 @@ ProjectManager::ProjectManager(QListView *view, ProcessManager *pman, QObject *p
     g->addWidget(label, 1, 1);
     g->setRowStretch(0, 1);
     g->setColumnStretch(0, 1);
-    TextMessageBrocker::instance().subscribe(TextMessages::ACTION_LABEL, [label](const QString& s) {
+    TextMessageBrocker::instance().subscribe(TextMessages::ACTION_LABEL, label, [label](const QString& s) {
         label->setVisible(!s.isEmpty());
         label->setText(s);
     });
@@ -150,8 +168,9 @@ ProjectManager::ProjectManager(QListView *view, ProcessManager *pman, QObject *p
         Q_UNUSED(code)
         if (status == QProcess::NormalExit) {
             auto res = findAllTargets(make);
-            priv->allTargets = res.first;
-            priv->allRefs = res.second;
+            priv->allTargets = res.targets;
+            priv->allRefs = res.refs;
+            priv->makeShell = res.shell;
             const auto targetKeys = priv->allTargets.keys();
             priv->targets = targetKeys.filter(priv->targetFilter);
             priv->targets.sort();
@@ -220,6 +239,11 @@ QStringList ProjectManager::targetsOfDependency(const QString &dep)
     return priv->allRefs.value(dep);
 }
 
+QString ProjectManager::makeShell() const
+{
+    return priv->makeShell;
+}
+
 void ProjectManager::createProject(const QString& projectFilePath, const QString& templateFile)
 {
     AppConfig::ensureExist(projectFilePath);
@@ -302,11 +326,10 @@ void ProjectManager::exportToDiff(const QString &patchFile)
             emit exportFinish(p->errorString());
         p->deleteLater();
     });
-    priv->pman->setStderrInterceptor(EXPORT_PROC, [](QProcess* p, const QString& text) {
-        QString s{ text };
-        TextMessageBrocker::instance()
-            .publish(TextMessages::STDERR_LOG,
-                     RegexHTMLTranslator::CONSOLE_TRANSLATOR(p, s));
+    auto stderrTopic = TextMessageBrocker::instance().topic(TextMessages::STDERR_LOG);
+    priv->pman->setStderrInterceptor(EXPORT_PROC, [stderrTopic](QProcess* p, const QString& text) {
+        Q_UNUSED(p)
+        TextMessageBrocker::instance().publish(stderrTopic, AnsiTextTranslator::strip(text));
     });
     priv->pman->start(EXPORT_PROC, "diff", { "-N", "-u", "-r", tmpDir.absolutePath(), "." }, {}, projectPath());
     TextMessageBrocker::instance()
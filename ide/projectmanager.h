@@ -47,6 +47,7 @@ public:
 
     QStringList dependenciesForTarget(const QString& target);
     QStringList targetsOfDependency(const QString& dep);
+    QString makeShell() const;
 
     void deleteOnCloseProject(QObject *p) {
         connect(this, &ProjectManager::projectClosed, p, &QObject::deleteLater);
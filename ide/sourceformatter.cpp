@@ -0,0 +1,71 @@
+/*
+ * This file is part of Embedded-IDE
+ * 
+ * Copyright 2019 Martin Ribelotta <martinribelotta@gmail.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "sourceformatter.h"
+#include "appconfig.h"
+
+#include <astyle_main.h>
+
+#include <QMutex>
+#include <QMutexLocker>
+
+// AStyle callbacks have no user data, errors are collected per thread
+static thread_local QStringList *currentErrors = nullptr;
+
+static STDCALL char* formatterAllocation(unsigned long memoryNeeded)
+{
+    return new char[memoryNeeded];
+}
+
+static STDCALL void formatterError(int errorNumber, const char* errorMessage)
+{
+    if (currentErrors)
+        currentErrors->append(QString("%1: %2").arg(errorNumber).arg(errorMessage));
+}
+
+SourceFormatter::SourceFormatter(const QByteArray &options) : opts(options)
+{
+}
+
+SourceFormatter SourceFormatter::fromConfig()
+{
+    auto& cfg = AppConfig::instance();
+    const auto style = cfg.editorFormatterStyle();
+    const auto indentType = QString{cfg.editorTabsToSpaces()? "spaces" : "tab"};
+    const auto indentCount = QString("%1").arg(cfg.editorTabWidth());
+    const auto extraAstyleParams = cfg.editorFormatterExtra();
+    return SourceFormatter(QString("--style=%1 --indent=%2=%3 %4")
+                           .arg(style, indentType, indentCount, extraAstyleParams).toLatin1());
+}
+
+SourceFormatter::Result SourceFormatter::format(const QByteArray &text) const
+{
+    // AStyle keeps global parser state (extern "C" tracking), one run at a time
+    static QMutex astyleLock;
+    QMutexLocker locker(&astyleLock);
+    Result r;
+    currentErrors = &r.errors;
+    char *out = AStyleMain(text.constData(), opts.constData(), formatterError, formatterAllocation);
+    currentErrors = nullptr;
+    if (out) {
+        r.text = QByteArray(out);
+        r.valid = true;
+        delete[] out;
+    }
+    return r;
+}
@@ -16,31 +16,30 @@
  * You should have received a copy of the GNU General Public License
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
-#include "regexhtmltranslator.h"
+#ifndef SOURCEFORMATTER_H
+#define SOURCEFORMATTER_H
 
-#include <QtDebug>
+#include <QByteArray>
+#include <QStringList>
 
-template<typename T>
-static RegexEntry mkEntry(const QString& r, const T& h) {
-    return RegexEntry{QRegularExpression{ r, QRegularExpression::MultilineOption }, QLatin1String{ h } };
-}
-
-const RegexList_t RegexHTMLTranslator::DEFAULT_REGEX =
-    {
-    mkEntry(R"((\r?\n))", "\\1<br>"),
-    mkEntry(R"( )", "&nbsp;"),
+class SourceFormatter
+{
+public:
+    struct Result {
+        QByteArray text;
+        QStringList errors;
+        bool valid = false;
     };
 
-RegexHTMLTranslator RegexHTMLTranslator::CONSOLE_TRANSLATOR{};
+    explicit SourceFormatter(const QByteArray& options = QByteArray());
 
-QString &RegexHTMLTranslator::operator()(QProcess *p, QString &s)
-{
-    Q_UNUSED(p);
-    s = s.toHtmlEscaped();
-    for(const auto& e: regexs) {
-        // qDebug() << "AFTER" << s;
-        s.replace(e.re, e.html);
-        // qDebug() << "BEFORE" << s;
-    }
-    return s;
-}
+    static SourceFormatter fromConfig();
+
+    const QByteArray& options() const { return opts; }
+    Result format(const QByteArray& text) const;
+
+private:
+    QByteArray opts;
+};
+
+#endif // SOURCEFORMATTER_H
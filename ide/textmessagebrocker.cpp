@@ -18,9 +18,19 @@
  */
 #include "textmessagebrocker.h"
 
+#include <QThread>
+
+#include <algorithm>
+
+static constexpr int RATE_WINDOW = 1000;
+
 TextMessageBrocker::TextMessageBrocker(QObject *parent) : QObject(parent)
 {
-
+    clock.start();
+    flushTimer.setSingleShot(true);
+    connect(&flushTimer, &QTimer::timeout, this, &TextMessageBrocker::flushPending);
+    // Only the current position matters to the editors
+    setCoalescing(TextMessages::DEBUG_IP_CHANGE, Coalescing::Latest);
 }
 
 TextMessageBrocker &TextMessageBrocker::instance()
@@ -31,7 +41,146 @@ TextMessageBrocker &TextMessageBrocker::instance()
     return *ptr;
 }
 
+TextMessageBrocker::Topic TextMessageBrocker::topic(const QString &name)
+{
+    QMutexLocker lock(&mutex);
+    return topicLocked(name);
+}
+
+TextMessageBrocker &TextMessageBrocker::subscribe(const QString &topic, QObject *context, const Handler &func)
+{
+    QMutexLocker lock(&mutex);
+    auto t = topicLocked(topic);
+    topics[t].subscribers.append({ context, context, func });
+    if (context != this && !contexts.contains(context)) {
+        contexts.insert(context);
+        connect(context, &QObject::destroyed, this, [this, context]() { unsubscribeAll(context); });
+    }
+    return *this;
+}
+
+void TextMessageBrocker::unsubscribeAll(QObject *context)
+{
+    QMutexLocker lock(&mutex);
+    contexts.remove(context);
+    for (auto& d: topics) {
+        auto it = std::remove_if(d.subscribers.begin(), d.subscribers.end(),
+                                 [context](const Subscriber& s) { return s.owner == context; });
+        d.subscribers.erase(it, d.subscribers.end());
+    }
+}
+
+void TextMessageBrocker::setCoalescing(const QString &topic, Coalescing mode, int interval)
+{
+    QMutexLocker lock(&mutex);
+    auto& d = topics[topicLocked(topic)];
+    d.mode = mode;
+    d.interval = interval;
+}
+
+QList<TextMessageBrocker::TopicStatistics> TextMessageBrocker::statistics() const
+{
+    QMutexLocker lock(&mutex);
+    QList<TopicStatistics> list;
+    for (const auto& d: topics)
+        list.append({ d.name, d.subscribers.size(), d.published, d.delivered, d.rate });
+    return list;
+}
+
 void TextMessageBrocker::publish(const QString &topic, const QString &message)
 {
-    emit published(topic, message);
+    publish(this->topic(topic), message);
+}
+
+void TextMessageBrocker::publish(Topic topic, const QString &message)
+{
+    bool direct;
+    bool schedule = false;
+    int interval = 0;
+    {
+        QMutexLocker lock(&mutex);
+        Q_ASSERT(topic >= 0 && topic < topics.size());
+        auto& d = topics[topic];
+        d.published++;
+        auto now = clock.elapsed();
+        if (now - d.windowStart >= RATE_WINDOW) {
+            d.rate = d.windowCount * 1000.0 / qMax<qint64>(RATE_WINDOW, now - d.windowStart);
+            d.windowStart = now;
+            d.windowCount = 0;
+        }
+        d.windowCount++;
+
+        // Other threads never touch the subscribers, they queue for the next flush
+        direct = d.mode == Coalescing::None && QThread::currentThread() == thread();
+        if (!direct) {
+            if (d.mode == Coalescing::Latest)
+                d.pending = QStringList{ message };
+            else
+                d.pending.append(message);
+            if (!d.flushScheduled) {
+                d.flushScheduled = true;
+                schedule = true;
+                interval = d.interval;
+            }
+        }
+    }
+    if (direct)
+        deliver(topic, message);
+    else if (schedule)
+        QMetaObject::invokeMethod(this, "scheduleFlush", Qt::AutoConnection, Q_ARG(int, interval));
+}
+
+void TextMessageBrocker::scheduleFlush(int interval)
+{
+    if (!flushTimer.isActive() || flushTimer.remainingTime() > interval)
+        flushTimer.start(interval);
+}
+
+void TextMessageBrocker::flushPending()
+{
+    struct Work { Topic topic; Coalescing mode; QStringList messages; };
+    QVector<Work> work;
+    {
+        QMutexLocker lock(&mutex);
+        for (int t = 0; t < topics.size(); t++) {
+            auto& d = topics[t];
+            if (d.pending.isEmpty())
+                continue;
+            work.append({ t, d.mode, d.pending });
+            d.pending.clear();
+            d.flushScheduled = false;
+        }
+    }
+    for (const auto& w: work) {
+        if (w.mode == Coalescing::Batch)
+            deliver(w.topic, w.messages.join(QString()));
+        else
+            for (const auto& m: w.messages)
+                deliver(w.topic, m);
+    }
+}
+
+int TextMessageBrocker::topicLocked(const QString &name)
+{
+    auto it = topicIndex.constFind(name);
+    if (it != topicIndex.constEnd())
+        return it.value();
+    TopicData d;
+    d.name = name;
+    topics.append(d);
+    return topicIndex[name] = topics.size() - 1;
+}
+
+void TextMessageBrocker::deliver(Topic t, const QString &message)
+{
+    // A copy, handlers may subscribe or destroy other subscribers
+    QVector<Subscriber> subscribers;
+    {
+        QMutexLocker lock(&mutex);
+        subscribers = topics.at(t).subscribers;
+        topics[t].delivered += quint64(subscribers.size());
+    }
+    for (const auto& s: subscribers)
+        if (s.context)
+            s.func(message);
 }
@@ -19,13 +19,24 @@
 #ifndef TEXTMESSAGEBROCKER_H
 #define TEXTMESSAGEBROCKER_H
 
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
 #include <QObject>
+#include <QPointer>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+
+#include <functional>
 
 namespace TextMessages {
 constexpr auto STDERR_LOG = "stderrLog";
 constexpr auto STDOUT_LOG = "stdoutLog";
 constexpr auto ACTION_LABEL = "actionLabel";
 constexpr auto DEBUG_IP_CHANGE = "debug_ip_change";
+constexpr auto FIND_AND_OPEN = "findAndOpen";
 };
 
 class TextMessageBrocker : public QObject
@@ -36,35 +47,81 @@ private:
     explicit TextMessageBrocker(QObject *parent = nullptr);
 
 public:
+    enum class Coalescing {
+        None,   // Every message is delivered
+        Batch,  // Messages are concatenated and delivered once
+        Latest, // Only the last message is delivered
+    };
+
+    using Topic = int;
+    using Handler = std::function<void (const QString&)>;
+
+    struct TopicStatistics {
+        QString name;
+        int subscribers;
+        quint64 published;
+        quint64 delivered;
+        double rate; // Published messages per second over the last second
+    };
+
     static TextMessageBrocker &instance();
 
-    template<typename Function>
-    TextMessageBrocker& subscribe(const QString& topic, Function func) {
-        connect(this, &TextMessageBrocker::published,
-                [this, topic, func](const QString& t, const QString& msg)
-        {
-            if (topic == t)
-                func(msg);
-        });
-        return *this;
+    Topic topic(const QString& name);
+
+    // Handlers run in the brocker thread and go away with their context
+    TextMessageBrocker& subscribe(const QString& topic, const Handler& func) {
+        return subscribe(topic, this, func);
     }
+    TextMessageBrocker& subscribe(const QString& topic, QObject *context, const Handler& func);
 
-    template<typename Class, typename Function>
-    TextMessageBrocker& subscribe(const QString& topic, Class obj, Function func) {
-        connect(this, &TextMessageBrocker::published,
-                [this, topic, obj, func](const QString& t, const QString& msg)
-        {
-            if (topic == t)
-                (obj->*func)(msg);
-        });
-        return *this;
+    template<typename Class>
+    TextMessageBrocker& subscribe(const QString& topic, Class *obj, void (Class::*func)(const QString&)) {
+        return subscribe(topic, obj, [obj, func](const QString& msg) { (obj->*func)(msg); });
     }
 
-signals:
-    void published(const QString& topic, const QString& message);
+    void unsubscribeAll(QObject *context);
+    void setCoalescing(const QString& topic, Coalescing mode, int interval = 0);
+    QList<TopicStatistics> statistics() const;
+
+    void publish(Topic topic, const QString& message);
 
 public slots:
     void publish(const QString& topic, const QString& message);
+
+private slots:
+    void scheduleFlush(int interval);
+    void flushPending();
+
+private:
+    struct Subscriber {
+        QPointer<QObject> context;
+        QObject *owner;
+        Handler func;
+    };
+
+    struct TopicData {
+        QString name;
+        QVector<Subscriber> subscribers;
+        Coalescing mode = Coalescing::None;
+        int interval = 0;
+        QStringList pending;
+        bool flushScheduled = false;
+        quint64 published = 0;
+        quint64 delivered = 0;
+        qint64 windowStart = 0;
+        int windowCount = 0;
+        double rate = 0.0;
+    };
+
+    int topicLocked(const QString& name);
+    void deliver(Topic t, const QString& message);
+
+    mutable QMutex mutex;
+    QHash<QString, Topic> topicIndex;
+    QVector<TopicData> topics;
+    QSet<QObject*> contexts;
+    QTimer flushTimer;
+    QElapsedTimer clock;
 };
 
 #endif // TEXTMESSAGEBROCKER_H